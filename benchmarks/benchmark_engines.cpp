@@ -0,0 +1,53 @@
+// Times the routines in compi_engines.hpp with inlined native integrands, with no Python
+// involved, reporting the mean time per integration.
+//      benchmark_engines [repeats]
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+
+#include "compi_engines.hpp"
+
+namespace {
+
+// Stops the compiler optimising away the integrations being timed
+volatile double sink;
+
+template<typename Integrate>
+void benchmark(const char* name, unsigned repeats, Integrate integrate){
+    // The first call generates any levels of the node tables not yet used, which is not included in the timing
+    sink = std::abs(integrate().result);
+
+    const auto start = std::chrono::steady_clock::now();
+    for(unsigned i = 0; i < repeats; ++i){
+        sink = std::abs(integrate().result);
+    }
+    const std::chrono::duration<double,std::micro> elapsed = std::chrono::steady_clock::now() - start;
+    std::printf("%-32s %10.3f us\n",name,elapsed.count()/repeats);
+}
+
+}
+
+int main(int argc, char** argv){
+    const unsigned repeats = argc > 1 ? static_cast<unsigned>(std::atoi(argv[1])) : 1000;
+    const double infinity = std::numeric_limits<double>::infinity();
+
+    auto oscillating = [](double x){ return std::exp(std::complex<double>(-x*x,5*x)); };
+    auto gaussian = [](double x){ return std::exp(-x*x); };
+    auto singular = [](double x){ return std::log(x); };
+
+    benchmark("trapezoidal exp(-x^2+5ix)",repeats,[&]{ return compi::trapezoidal(oscillating,-1.0,1.0,{12,1e-10}); });
+    benchmark("gauss_kronrod exp(-x^2+5ix)",repeats,[&]{ return compi::gauss_kronrod(oscillating,-1.0,1.0); });
+    benchmark("tanh_sinh exp(-x^2+5ix)",repeats,[&]{ return compi::tanh_sinh(oscillating,-1.0,1.0); });
+    benchmark("tanh_sinh log(x)",repeats,[&]{ return compi::tanh_sinh(singular,0.0,1.0); });
+    benchmark("sinh_sinh exp(-x^2)",repeats,[&]{ return compi::sinh_sinh(gaussian); });
+    benchmark("exp_sinh exp(-x^2)",repeats,[&]{ return compi::exp_sinh(gaussian,0.0,infinity); });
+    benchmark("quad log(x)",repeats,[&]{ return compi::quad(singular,0.0,1.0); });
+    benchmark("integrate_with_grad exp(-a*x^2)",repeats,[&]{
+        return compi::integrate_with_grad([](double x, const auto& p){ return exp(-p[0]*x*x); },-infinity,infinity,std::array<double,1>{1.0});
+    });
+    return 0;
+}
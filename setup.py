@@ -1,6 +1,7 @@
 from setuptools import setup,Extension
 import setuptools.command
-import os, sys, re, importlib
+from distutils.errors import CCompilerError, DistutilsError
+import os, sys, re, importlib, subprocess
 
 def check_valid_boost_path(path):
       '''
@@ -47,7 +48,13 @@ compi_extension = Extension('compi',[src+f for f in ('compi.c',
                                             'sinh_sinh.cpp',
                                             'exp_sinh.cpp',
                                             'trapezoid.cpp',
-                                            'IntegrandFunctionWrapper.cpp')],
+                                            'quad.cpp',
+                                            'gradient.cpp',
+                                            'IntegrandFunctionWrapper.cpp',
+                                            'expression.cpp',
+                                            'result_cache.cpp',
+                                            'node_tables.cpp',
+                                            'capi.cpp')],
 
                                        extra_compile_args=["-std=c++17"]
                             )
@@ -80,6 +87,23 @@ cmds = {cmd:add_boost_path_option(
                 getattr(importlib.import_module("setuptools.command." + cmd),cmd))
             for cmd in setuptools.command.__all__}
 
+def build_node_tables(build_ext):
+    '''
+    Compiles and runs tools/generate_node_tables.cpp, writing the double exponential node tables
+    next to the extension, where compi memory maps them when it is imported. If this fails compi
+    still works, generating the tables in each process instead, so only a warning is given
+    '''
+    output = os.path.join(os.path.dirname(build_ext.get_ext_fullpath('compi')),'compi_node_tables.bin')
+    try:
+        objects = build_ext.compiler.compile(['tools/generate_node_tables.cpp'],
+                                             output_dir=build_ext.build_temp,
+                                             include_dirs=compi_extension.include_dirs + [src],
+                                             extra_postargs=["-std=c++17"])
+        build_ext.compiler.link_executable(objects,'generate_node_tables',output_dir=build_ext.build_temp,target_lang='c++')
+        subprocess.check_call([os.path.join(build_ext.build_temp,build_ext.compiler.executable_filename('generate_node_tables')),output])
+    except (CCompilerError, DistutilsError, OSError, subprocess.CalledProcessError) as e:
+        print("warning: could not generate the node tables, which will be generated at runtime instead: "+str(e))
+
 def build_run(self):
     '''
     The run method for the build_ext command expecting a boost-path
@@ -87,6 +111,7 @@ def build_run(self):
     if compi_extension.include_dirs == []:
         raise FileNotFoundError("No boost path entered")
     super(type(self),self).run()
+    build_node_tables(self)
 
 cmds['build_ext'].run = build_run
 
@@ -96,5 +121,8 @@ setup(name='Compi',
       author_email='conorgjackson@gmail.com',
       url='https://github.com/CGJackson/Compi',
       ext_modules=[compi_extension],
+      package_dir={'':'source'},
+      py_modules=['compi_pool'],
+      headers=['source/compi_capi.h','source/compi_engines.hpp','source/compi_node_tables.hpp'],
       cmdclass = cmds
 )
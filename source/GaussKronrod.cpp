@@ -1,13 +1,15 @@
 #include "compi.hpp"
 
 #include <complex>
-#include <unordered_map>
+#include <functional>
 #include <algorithm>
 #include <utility>
 
 #include <boost/math/quadrature/gauss_kronrod.hpp>
 #include <boost/math/tools/precision.hpp>
 
+#include "compi_engines.hpp"
+
 extern "C" {
     #include "integration_routines.h"
 }
@@ -20,6 +22,7 @@ extern "C" {
 
 
 struct GaussKronrodParameters: public RoutineParametersBase{
+    static constexpr const char* name = "gauss_kronrod";
     Real x_min;
     Real x_max;
     unsigned points = 31;
@@ -29,41 +32,29 @@ struct GaussKronrodParameters: public RoutineParametersBase{
         constexpr std::array<const char*,1> keyword_only_args = {"points"};
         constexpr auto keywords = generate_keyword_list<IntegralRange::finite>(dumby_arg,dumby_arg,keyword_only_args);
 
-        if(!PyArg_ParseTupleAndKeywords(routine_args,routine_kwargs,"Odd|OO$pIdI",const_cast<char**>(keywords.data()),
+        if(!PyArg_ParseTupleAndKeywords(routine_args,routine_kwargs,"Odd|OO$pIddndOI",const_cast<char**>(keywords.data()),
                 &integrand,&x_min,&x_max,
                 &args,&kw,
-                &full_output, &max_levels,&tolerance,&points)){
+                &full_output, &max_levels,&tolerance,&atol,&max_evaluations,&timeout,&cache_key,&points)){
             throw could_not_parse_arguments("Unable to parse python arguments to C variables");
         }
+
+        // Checked here, rather than when the routine is run, as the GIL may not be held then
+        if(points != 15 && points != 31 && points != 41 && points != 51 && points != 61){
+            PyErr_SetString(PyExc_ValueError,"Invalid number of points for gauss_kronrod");
+            throw could_not_parse_arguments("Invalid number of points for gauss_kronrod");
+        }
+    }
+
+    PyObject* routine_arguments() const noexcept{
+        return Py_BuildValue("(ddI)",x_min,x_max,points);
     }
 
 };
 
 GaussKronrodParameters::result_type run_integration_routine(const compi_internal::IntegrandFunctionWrapper& f, const GaussKronrodParameters& parameters){
-    using std::complex;
-    using namespace compi_internal;
-    using boost::math::quadrature::gauss_kronrod;
-    using IntegrationRoutine = complex<Real>(*)(IntegrandFunctionWrapper, Real, Real, unsigned, Real, Real*, Real*);
-
-    // The possible tempates for the different allowed numbers of divisions are instasiated, 
-    // so that the Python runtime can select which one to use
-    static const std::unordered_map<unsigned,IntegrationRoutine> integration_routines{{15,gauss_kronrod<Real,15>::integrate},
-                                                                                      {31,gauss_kronrod<Real,31>::integrate},
-                                                                                      {41,gauss_kronrod<Real,41>::integrate},
-                                                                                      {51,gauss_kronrod<Real,51>::integrate},
-                                                                                      {61,gauss_kronrod<Real,61>::integrate}
-                                                                                     };
-
-    GaussKronrodParameters::result_type result;
-
-    try{
-        result.result = integration_routines.at(parameters.points)(f,parameters.x_min,parameters.x_max,parameters.max_levels,parameters.tolerance,&(result.err),&(result.l1));
-    } catch (const std::out_of_range& e){
-        PyErr_SetString(PyExc_ValueError,"Invalid number of points for gauss_kronrod");
-        throw unable_to_call_integration_routine("Invalid number of points for gauss_kronrod");
-    }
-
-    return result;
+    return compi::gauss_kronrod(std::cref(f),parameters.x_min,parameters.x_max,
+                                compi::GaussKronrodOptions{parameters.max_levels,parameters.tolerance,parameters.points,parameters.atol});
 }
 
 template<unsigned points>
@@ -86,8 +77,7 @@ PyObject* generate_full_output_dict(const GaussKronrodParameters::result_type& r
     // The boost API returning the abscissa and weights simply spesifies that
     // they are returned as a (reference to a) random access container. 
     // Since this could (reasonably) depend on points (e.g. array<Real,points>)
-    // it is awkward to use the map based appraoch in run_integation_routine
-    // and instead we use more verbose a template/switch based approach
+    // a template/switch based approach is used
 
     std::pair<PyObject*,PyObject*> abscissa_and_weights;
     switch(parameters.points){
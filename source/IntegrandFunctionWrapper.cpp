@@ -1,9 +1,13 @@
 #include "compi.hpp"
 
+#include <chrono>
 #include <complex>
+#include <memory>
 #include <utility>
 #include <vector>
 #include <stdexcept>
+#include <string>
+#include <unordered_map>
 
 #include "IntegrandFunctionWrapper.hpp"
 #include "utils.hpp"
@@ -12,7 +16,7 @@ namespace compi_internal {
 using std::complex;
 
 IntegrandFunctionWrapper::IntegrandFunctionWrapper(const IntegrandFunctionWrapper& other)
-            :callback{other.callback}, args{other.args},kwargs{other.kwargs} {
+            :callback{other.callback}, args{other.args},kwargs{other.kwargs},expression{other.expression},budget{other.budget} {
             Py_INCREF(other.callback);
             if(kwargs){
                 Py_INCREF(kwargs);
@@ -28,7 +32,7 @@ IntegrandFunctionWrapper::IntegrandFunctionWrapper(const IntegrandFunctionWrappe
         // args and kwargs, however a fair game (so actually calling this callable may
         // throw a Python TypeError due to the wrong number of args being passed)
 IntegrandFunctionWrapper::IntegrandFunctionWrapper(IntegrandFunctionWrapper&& other)
-            :callback{other.callback}, args{std::move(other.args)} ,kwargs{other.kwargs}{
+            :callback{other.callback}, args{std::move(other.args)} ,kwargs{other.kwargs},expression{other.expression},budget{other.budget}{
             Py_INCREF(other.callback);
 
             other.kwargs = nullptr;
@@ -61,13 +65,23 @@ IntegrandFunctionWrapper::IntegrandFunctionWrapper(PyObject * func,
         throw unable_to_construct_wrapper("Function keyword arguments passed to IntegrandFunctionWrapper cannot be NULL");
     }
 
+    if(PyUnicode_Check(callback)){
+        compileExpression(new_args,new_kw);
+        Py_INCREF(callback);
+        return;
+    }
+
     if(!PyCallable_Check(callback)){
         throw function_not_callable("The Python Object for IntegrandFunctionWrapper to wrap was not callable", "Unable to wrap uncallable object");
     }
 
     if(PyDict_Check(new_kw)){
-        kwargs = new_kw;
-        Py_INCREF(kwargs);
+        // The wrapper keeps its own copy of the keyword arguments, so that the dict passed
+        // in may be modified by other threads while the integrand is being evaluated
+        kwargs = PyDict_Copy(new_kw);
+        if(kwargs == NULL){
+            throw unable_to_construct_wrapper("Unable to copy keyword arguments");
+        }
     }
     else if(new_kw != Py_None){
         throw kwargs_given_not_dict("The keyword args given to IntegrandFunctionWrapper were not a Python dict or None","The keyword arguments passed to the function wrapper were not a valid python dict");
@@ -89,7 +103,7 @@ IntegrandFunctionWrapper::IntegrandFunctionWrapper(PyObject * func,
     if(extra_arg_count >= PY_SSIZE_T_MAX){
         PyErr_SetString(PyExc_TypeError,"Too many arguments provided to integrand function");
         Py_DECREF(callback);
-        Py_DECREF(kwargs);
+        Py_XDECREF(kwargs);
         throw unable_to_construct_wrapper("Too many arguments provided");
     }
 
@@ -102,6 +116,51 @@ IntegrandFunctionWrapper::IntegrandFunctionWrapper(PyObject * func,
     }
 }
 
+void IntegrandFunctionWrapper::compileExpression(PyObject* new_args, PyObject* new_kw){
+    if(new_args != Py_None && !(PyTuple_Check(new_args) && PyTuple_GET_SIZE(new_args) == 0)){
+        throw arg_list_not_tuple("Positional arguments given for an expression integrand", "Positional arguments cannot be passed to an expression. Pass the values of its parameters in kwargs");
+    }
+    if(new_kw != Py_None && !PyDict_Check(new_kw)){
+        throw kwargs_given_not_dict("The keyword args given to IntegrandFunctionWrapper were not a Python dict or None","The keyword arguments passed to the function wrapper were not a valid python dict");
+    }
+
+    Py_ssize_t source_size;
+    const char* source = PyUnicode_AsUTF8AndSize(callback,&source_size);
+    if(source == NULL){
+        throw unable_to_construct_wrapper("Unable to read expression source");
+    }
+
+    expression = std::make_shared<ExpressionIntegrand>(compile_expression(std::string(source,source_size)),expression_parameter_values(new_kw));
+}
+
+std::unordered_map<std::string,complex<Real>> expression_parameter_values(PyObject* kw){
+    std::unordered_map<std::string,complex<Real>> parameter_values{};
+    if(kw != Py_None){
+        std::unique_ptr<PyObject,PyObjectDecRef> items{dict_items(kw)};
+        if(!items){
+            throw PythonError("Unable to read the parameters of an expression");
+        }
+        for(Py_ssize_t i = 0; i < PyList_GET_SIZE(items.get()); ++i){
+            PyObject* key = PyTuple_GET_ITEM(PyList_GET_ITEM(items.get(),i),0);
+            PyObject* value = PyTuple_GET_ITEM(PyList_GET_ITEM(items.get(),i),1);
+            const char* name = PyUnicode_Check(key) ? PyUnicode_AsUTF8(key) : NULL;
+            if(name == NULL){
+                PyErr_Clear();
+                throw invalid_expression("Expression parameter name was not a str","The names of the parameters of an expression must be str");
+            }
+            if(!convertable_to_py_complex(value)){
+                throw invalid_expression("Expression parameter value was not a number","The values of the parameters of an expression must be numbers");
+            }
+            const Py_complex c_value = PyComplex_AsCComplex(value);
+            if(PyErr_Occurred()){
+                throw PythonError("Unable to convert expression parameter to complex");
+            }
+            parameter_values.emplace(name,complex_from_c_complex(c_value));
+        }
+    }
+    return parameter_values;
+}
+
 PyObject* IntegrandFunctionWrapper::buildArgTuple(Real x) const{
     PyObject* py_x = PyFloat_FromDouble(x);
     if(py_x == NULL){
@@ -122,11 +181,42 @@ PyObject* IntegrandFunctionWrapper::buildArgTuple(Real x) const{
     return arg_tuple;
 }
 
+void IntegrandFunctionWrapper::set_budget(size_t max_evaluations, Real timeout){
+    using std::chrono::steady_clock;
+    budget = std::make_shared<EvaluationBudget>();
+    budget->max_evaluations = max_evaluations;
+    // Timeouts longer than this are treated as no timeout, to avoid overflowing the clock
+    constexpr Real longest_timeout = 1e9;
+    budget->has_deadline = timeout < longest_timeout;
+    if(budget->has_deadline){
+        budget->deadline = steady_clock::now() + std::chrono::duration_cast<steady_clock::duration>(std::chrono::duration<Real>(timeout));
+    }
+}
+
 complex<Real> IntegrandFunctionWrapper::operator()(Real x) const{
     // Calls the Python function callback with x as a python float
     // and args as its other arguments and reutrns the result as a
     // std::complex
     
+    if(budget){
+        const auto previous = budget->evaluated.find(x);
+        if(previous != budget->evaluated.end()){
+            return previous->second;
+        }
+        if(budget->replay_only || budget->evaluations >= budget->max_evaluations 
+                || (budget->has_deadline && std::chrono::steady_clock::now() >= budget->deadline)){
+            throw evaluation_budget_exhausted("Evaluation budget of integrand exhausted");
+        }
+        ++(budget->evaluations);
+    }
+
+    if(expression){
+        const complex<Real> expression_result = (*expression)(x);
+        if(budget){
+            budget->evaluated.emplace(x,expression_result);
+        }
+        return expression_result;
+    }
     
     PyObject* arg_tuple = this->buildArgTuple(x);
     PyObject* py_result = PyObject_Call(callback, arg_tuple, kwargs);
@@ -147,6 +237,10 @@ complex<Real> IntegrandFunctionWrapper::operator()(Real x) const{
     complex<Real> cpp_result = complex_from_c_complex(PyComplex_AsCComplex(py_result));
 
     Py_DECREF(py_result);
+
+    if(budget){
+        budget->evaluated.emplace(x,cpp_result);
+    }
     
     return cpp_result;
 }
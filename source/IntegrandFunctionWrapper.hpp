@@ -3,8 +3,16 @@
 
 #include "compi.hpp"
 
+#include <chrono>
+#include <complex>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
+#include "expression.hpp"
+
 namespace compi_internal {
 
 // Exceptions to be used in IntegrandFunctionWrapper
@@ -48,14 +56,56 @@ class function_did_not_return_complex: public std::invalid_argument{
 class unable_to_form_arg_tuple: public std::runtime_error{
     using std::runtime_error::runtime_error;
 };
+// Thrown when evaluating the integrand would exceed its EvaluationBudget.
+// No Python error is set, as the routine is expected to recover a partial result
+class evaluation_budget_exhausted: public std::runtime_error{
+    using std::runtime_error::runtime_error;
+};
 
+// Limits on the number of evaluations of, and the wall clock time spent in, an integrand.
+// While a budget is in place every evaluation is recorded, so that once it is exhausted
+// the integration can be rerun with fewer levels using only the values already computed.
+struct EvaluationBudget{
+    size_t max_evaluations;
+    std::chrono::steady_clock::time_point deadline;
+    bool has_deadline;
+
+    size_t evaluations = 0;
+    bool replay_only = false;
+    std::unordered_map<Real,std::complex<Real>> evaluated{};
+};
+
+// Converts a dict of the values of the parameters of an expression, or None, to C++ values.
+// Throws invalid_expression if a name is not a str or a value is not a number
+std::unordered_map<std::string,std::complex<Real>> expression_parameter_values(PyObject* kw);
+
+// The wrapper holds its own references to the callback and all of its arguments, and never
+// modifies them after construction. Its EvaluationBudget and the registers of an expression
+// integrand are updated by every evaluation without a lock, and are shared with its copies, so
+// a wrapper and its copies must only be called from one thread at a time. Each integration
+// constructs its own wrapper, so integrations may run in several threads at once, including
+// on free-threaded builds of Python.
+//
+// The integrand may also be given as a Python str containing an expression in x (see 
+// CompiledExpression), with the values of its parameters given by the keyword arguments.
+// The expression is then evaluated natively, without calling into Python.
 class IntegrandFunctionWrapper {
     private:
         // IMPORTANT - Class invariant: callback will at all times point to a callable
-        // Python object, i.e. an IntegrandFunctionWrapper will at all times wrap a function
+        // Python object, i.e. an IntegrandFunctionWrapper will at all times wrap a function,
+        // unless expression is not NULL, in which case callback is the source of the expression
         PyObject* callback;
         std::vector<PyObject*> args;
         PyObject* kwargs = NULL;
+
+        std::shared_ptr<ExpressionIntegrand> expression{};
+
+        // Compiles the expression in callback, binding the values of its parameters from new_kw
+        void compileExpression(PyObject* new_args, PyObject* new_kw);
+
+        // Shared between copies of the wrapper, since the boost routines take their
+        // integrand by value. NULL if there is no budget
+        std::shared_ptr<EvaluationBudget> budget{};
         
         // Forms a python tuple with a Py_Float of x in the first element, followed by the elements of args
         PyObject* buildArgTuple(Real x) const;
@@ -90,6 +140,27 @@ class IntegrandFunctionWrapper {
             }
         }
 
+        // Limits the integrand to max_evaluations evaluations and timeout seconds of wall 
+        // clock time from this call. timeout may be infinite
+        void set_budget(size_t max_evaluations, Real timeout);
+
+        // After this is called only points already evaluated under the budget can be evaluated
+        void replay_evaluations_only() noexcept{
+            if(budget){
+                budget->replay_only = true;
+            }
+        }
+
+        // The number of evaluations of the integrand made under the budget. 0 if there is no budget
+        size_t evaluations() const noexcept{
+            return budget ? budget->evaluations : 0;
+        }
+
+        // True unless the integrand is an expression, which can be evaluated without the GIL
+        bool requiresGIL() const noexcept{
+            return !expression;
+        }
+
         std::complex<Real> operator()(Real x) const;
 };
 
@@ -97,6 +168,9 @@ inline void swap(IntegrandFunctionWrapper& first, IntegrandFunctionWrapper& seco
             using std::swap;
             swap(first.callback,second.callback);
             swap(first.args,second.args);
+            swap(first.kwargs,second.kwargs);
+            swap(first.budget,second.budget);
+            swap(first.expression,second.expression);
 }
 }
 
@@ -0,0 +1,191 @@
+#include "compi.hpp"
+
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <cstring>
+#include <exception>
+#include <limits>
+#include <stdexcept>
+
+extern "C" {
+    #include "compi_capi.h"
+}
+
+#include "compi_engines.hpp"
+
+// Implementation of the C API declared in compi_capi.h, over the routines in compi_engines.hpp.
+// Nothing here may call into Python, since the routines can be called without the GIL.
+
+namespace {
+
+class integrand_failed: public std::runtime_error{
+    using std::runtime_error::runtime_error;
+};
+
+// Wraps a native integrand and its context as a callable which boost can integrate.
+// Copied by value by the boost routines, so holds no state of its own
+class NativeIntegrand{
+    private:
+        CompiIntegrand f;
+        void* context;
+    public:
+        NativeIntegrand(CompiIntegrand f, void* context) noexcept: f{f}, context{context}{}
+
+        std::complex<Real> operator()(Real x) const{
+            CompiComplex value{0.0,0.0};
+            if(f(x,context,&value) != 0){
+                throw integrand_failed("Integrand returned an error");
+            }
+            return std::complex<Real>(value.real,value.imag);
+        }
+};
+
+// Copies the options shared by every routine from the defaults of the C++ library
+template<typename EngineOptions>
+void copy_options(const EngineOptions& defaults, CompiOptions* options){
+    options->size = sizeof(CompiOptions);
+    options->max_levels = defaults.max_levels;
+    options->tolerance = defaults.tolerance;
+    options->atol = defaults.atol;
+}
+
+int default_options(int routine, CompiOptions* options){
+    if(!options){
+        return COMPI_INVALID_ARGUMENT;
+    }
+    switch(routine){
+        case COMPI_TRAPEZOIDAL:
+            copy_options(compi::TrapezoidalOptions{},options);
+            return COMPI_OK;
+        case COMPI_GAUSS_KRONROD:
+            copy_options(compi::GaussKronrodOptions{},options);
+            return COMPI_OK;
+        case COMPI_TANH_SINH:
+        case COMPI_SINH_SINH:
+        case COMPI_EXP_SINH:
+            copy_options(compi::Options{},options);
+            return COMPI_OK;
+        default:
+            return COMPI_INVALID_ARGUMENT;
+    }
+}
+
+const char* status_message(int status){
+    switch(status){
+        case COMPI_OK:
+            return "Success";
+        case COMPI_INVALID_ARGUMENT:
+            return "Invalid argument";
+        case COMPI_INTEGRAND_ERROR:
+            return "The integrand returned an error";
+        case COMPI_DOMAIN_ERROR:
+            return "The integral could not be evaluated for this integrand, e.g. it does not go to zero at infinity";
+        case COMPI_INTERNAL_ERROR:
+            return "Internal error";
+        default:
+            return "Unknown status";
+    }
+}
+
+// The size of the options of the first version of the API, which every caller provides
+constexpr std::size_t min_options_size = offsetof(CompiOptions,atol) + sizeof(CompiOptions::atol);
+
+// Runs integrate(f, options), which returns the compi::Result of the integration,
+// and converts the outcome into a status code and CompiResult. options, if not NULL, is read
+// up to its size, and any options after that take the defaults of routine
+template<typename Routine>
+int run_routine(int routine, CompiIntegrand f, void* context, const CompiOptions* options, CompiResult* result, Routine integrate) noexcept{
+    if(!f || !result){
+        return COMPI_INVALID_ARGUMENT;
+    }
+    CompiOptions chosen_options;
+    default_options(routine,&chosen_options);
+    if(options){
+        if(options->size < min_options_size || options->size > sizeof(CompiOptions)){
+            return COMPI_INVALID_ARGUMENT;
+        }
+        std::memcpy(&chosen_options,options,options->size);
+    }
+    if(!(chosen_options.tolerance > 0) || !(chosen_options.atol >= 0)){
+        return COMPI_INVALID_ARGUMENT;
+    }
+
+    try{
+        const compi::Result<std::complex<Real>> outcome = integrate(NativeIntegrand(f,context),chosen_options);
+
+        result->result = CompiComplex{outcome.result.real(),outcome.result.imag()};
+        result->error = outcome.err;
+        result->l1 = outcome.l1;
+        result->levels = outcome.levels;
+        result->converged = outcome.converged;
+        return COMPI_OK;
+    } catch(const integrand_failed& e){
+        return COMPI_INTEGRAND_ERROR;
+    } catch(const std::invalid_argument& e){
+        return COMPI_INVALID_ARGUMENT;
+    } catch(const std::domain_error& e){
+        return COMPI_DOMAIN_ERROR;
+    } catch(...){
+        return COMPI_INTERNAL_ERROR;
+    }
+}
+
+int trapezoidal(CompiIntegrand f, void* context, double a, double b, const CompiOptions* options, CompiResult* result){
+    return run_routine(COMPI_TRAPEZOIDAL,f,context,options,result,
+        [a,b](NativeIntegrand integrand, const CompiOptions& options){
+            if(!std::isfinite(a) || !std::isfinite(b)){
+                throw std::invalid_argument("trapezoidal requires finite bounds");
+            }
+            return compi::trapezoidal(integrand,a,b,compi::TrapezoidalOptions{options.max_levels,options.tolerance,false,false,options.atol});
+        });
+}
+
+int gauss_kronrod(CompiIntegrand f, void* context, double a, double b, unsigned points, const CompiOptions* options, CompiResult* result){
+    return run_routine(COMPI_GAUSS_KRONROD,f,context,options,result,
+        [a,b,points](NativeIntegrand integrand, const CompiOptions& options){
+            return compi::gauss_kronrod(integrand,a,b,compi::GaussKronrodOptions{options.max_levels,options.tolerance,points,options.atol});
+        });
+}
+
+int tanh_sinh(CompiIntegrand f, void* context, double a, double b, const CompiOptions* options, CompiResult* result){
+    return run_routine(COMPI_TANH_SINH,f,context,options,result,
+        [a,b](NativeIntegrand integrand, const CompiOptions& options){
+            return compi::tanh_sinh(integrand,a,b,compi::Options{options.max_levels,options.tolerance,options.atol});
+        });
+}
+
+int sinh_sinh(CompiIntegrand f, void* context, const CompiOptions* options, CompiResult* result){
+    return run_routine(COMPI_SINH_SINH,f,context,options,result,
+        [](NativeIntegrand integrand, const CompiOptions& options){
+            return compi::sinh_sinh(integrand,compi::Options{options.max_levels,options.tolerance,options.atol});
+        });
+}
+
+int exp_sinh(CompiIntegrand f, void* context, double b, int interval_infinity, const CompiOptions* options, CompiResult* result){
+    if(interval_infinity == 0){
+        return COMPI_INVALID_ARGUMENT;
+    }
+    return run_routine(COMPI_EXP_SINH,f,context,options,result,
+        [b,interval_infinity](NativeIntegrand integrand, const CompiOptions& options){
+            constexpr Real infinity = std::numeric_limits<Real>::infinity();
+            const compi::Options chosen{options.max_levels,options.tolerance,options.atol};
+            if(interval_infinity > 0){
+                return compi::exp_sinh(integrand,b,infinity,chosen);
+            }
+            return compi::exp_sinh(integrand,-infinity,b,chosen);
+        });
+}
+
+}
+
+extern "C" const CompiCAPI compi_c_api = {
+    COMPI_CAPI_VERSION,
+    default_options,
+    status_message,
+    trapezoidal,
+    gauss_kronrod,
+    tanh_sinh,
+    sinh_sinh,
+    exp_sinh
+};
@@ -1,5 +1,8 @@
 #include "compi.hpp"
 #include "integration_routines.h"
+#include "result_cache.h"
+#include "node_tables.h"
+#include "compi_capi.h"
 #include "doc_strings.h"
 
 /* Method Table */
@@ -14,19 +17,64 @@ static PyMethodDef CompiMethods[] = {
     SINH_SINH_DOCS},
     {"exp_sinh", (PyCFunction) exp_sinh, METH_VARARGS | METH_KEYWORDS,
     EXP_SINH_DOCS},
+    {"quad", (PyCFunction) quad, METH_VARARGS | METH_KEYWORDS,
+    QUAD_DOCS},
+    {"integrate_with_grad", (PyCFunction) integrate_with_grad, METH_VARARGS | METH_KEYWORDS,
+    INTEGRATE_WITH_GRAD_DOCS},
+    {"configure_cache", (PyCFunction) configure_cache, METH_VARARGS | METH_KEYWORDS,
+    CONFIGURE_CACHE_DOCS},
+    {"clear_cache", (PyCFunction) clear_cache, METH_VARARGS | METH_KEYWORDS,
+    CLEAR_CACHE_DOCS},
+    {"cache_info", (PyCFunction) cache_info, METH_NOARGS,
+    CACHE_INFO_DOCS},
     {NULL,NULL,0,NULL}
 };
 
+/* Table of C API entry points, defined in capi.cpp */
+extern const CompiCAPI compi_c_api;
+
+/* Adds the C API to the module as a capsule, so that other extensions can find it with
+   PyCapsule_Import (see compi_capi.h), and maps the node tables generated at build time */
+static int compi_exec(PyObject* module){
+    load_shared_node_tables(module);
+
+    PyObject* capsule = PyCapsule_New((void*) &compi_c_api, COMPI_CAPSULE_NAME, NULL);
+    if(!capsule){
+        return -1;
+    }
+    if(PyModule_AddObject(module, "_C_API", capsule) < 0){
+        Py_DECREF(capsule);
+        return -1;
+    }
+    return 0;
+}
+
+/* Module slots for multi-phase initialization.
+   compi keeps no Python objects at global scope, and the node tables are
+   guarded by their own locks, so the module can be loaded into subinterpreters
+   with their own GIL and used without the GIL on free-threaded builds */
+static PyModuleDef_Slot CompiSlots[] = {
+    {Py_mod_exec, compi_exec},
+#if PY_VERSION_HEX >= 0x030C0000
+    {Py_mod_multiple_interpreters, Py_MOD_PER_INTERPRETER_GIL_SUPPORTED},
+#endif
+#if PY_VERSION_HEX >= 0x030D0000
+    {Py_mod_gil, Py_MOD_GIL_NOT_USED},
+#endif
+    {0, NULL}
+};
+
 /* Module definition Structure */
 static struct PyModuleDef CompiModule = {
     PyModuleDef_HEAD_INIT,
     "compi",/* Module name */
     COMPI_DOCS, 
-    -1, /* Module keeps state at global scope */
-    CompiMethods
+    0, /* Module keeps no per-module state */
+    CompiMethods,
+    CompiSlots
 };
 
 /* Module initialization function */
 PyMODINIT_FUNC PyInit_compi(void){
-    return PyModule_Create(&CompiModule);
+    return PyModuleDef_Init(&CompiModule);
 }
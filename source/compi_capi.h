@@ -0,0 +1,121 @@
+#ifndef COMPI_CAPI_GUARD
+#define COMPI_CAPI_GUARD
+
+/* C API for calling the compi integration routines directly from other extension modules,
+   with native integrands and without any Python objects or argument parsing.
+
+   Usage, from C, C++ or Cython with the GIL held at import time:
+
+        const CompiCAPI* compi_api = compi_import_capi();
+        if(!compi_api){ ...handle the ImportError... }
+
+        CompiOptions options;
+        compi_api->default_options(COMPI_TANH_SINH, &options);
+        options.tolerance = 1e-10;
+        CompiResult result;
+        int status = compi_api->tanh_sinh(my_integrand, &my_context, 0.0, 1.0, &options, &result);
+
+   The routines never call into Python, so may be called with or without the GIL held, from
+   any thread. They share compi's node tables with the Python interface.
+
+   Compatibility: new entry points are only ever added to the end of CompiCAPI, and new
+   options to the end of CompiOptions, with the version increased. A module compiled against
+   this header therefore works with any compi whose version is at least the COMPI_CAPI_VERSION
+   it was compiled with. The routines tell which options a caller was compiled with from
+   CompiOptions.size, so options added later take their defaults for older callers. */
+
+#include <stddef.h>
+
+#define COMPI_CAPI_VERSION 1
+#define COMPI_CAPSULE_NAME "compi._C_API"
+
+/* Status codes returned by the routines */
+#define COMPI_OK 0
+#define COMPI_INVALID_ARGUMENT 1  /* e.g. a NULL integrand or an invalid number of points */
+#define COMPI_INTEGRAND_ERROR 2   /* the integrand returned a non-zero value */
+#define COMPI_DOMAIN_ERROR 3      /* e.g. the integrand does not go to zero at infinity */
+#define COMPI_INTERNAL_ERROR 4    /* any other failure, e.g. running out of memory */
+
+/* Routines, for default_options */
+#define COMPI_TRAPEZOIDAL 0
+#define COMPI_GAUSS_KRONROD 1
+#define COMPI_TANH_SINH 2
+#define COMPI_SINH_SINH 3
+#define COMPI_EXP_SINH 4
+
+typedef struct {
+    double real;
+    double imag;
+} CompiComplex;
+
+/* Evaluates the integrand at x, writing the value to *value. context is passed through
+   unchanged from the call to the routine. Must return 0 on success. Any other value stops
+   the integration, which returns COMPI_INTEGRAND_ERROR */
+typedef int (*CompiIntegrand)(double x, void* context, CompiComplex* value);
+
+/* Should be filled in by default_options, which sets size, before changing any options.
+   Otherwise size must be set to sizeof(CompiOptions) */
+typedef struct {
+    size_t size;
+    unsigned max_levels; /* maximum levels of refinement, as for the Python interface */
+    double tolerance;    /* maximum relative error */
+    double atol;         /* maximum absolute error, 0 for none */
+} CompiOptions;
+
+typedef struct {
+    CompiComplex result;
+    double error;
+    double l1;          /* estimate of the L1 norm of the integrand */
+    size_t levels;      /* levels of refinement used, where the routine reports them. 0 otherwise */
+    int converged;      /* non-zero if error <= max(atol, tolerance*|result|) or error <= tolerance*l1 */
+} CompiResult;
+
+/* For every routine, options may be NULL for the defaults of that routine. On failure result is
+   left unchanged */
+typedef struct {
+    unsigned version;
+
+    /* Fills in the default options of routine (one of COMPI_TRAPEZOIDAL, ... COMPI_EXP_SINH),
+       which are those of the Python interface. For trapezoidal they are 12 levels and a
+       tolerance of machine epsilon, and for every other routine 15 levels and the sqrt of
+       machine epsilon. Returns COMPI_INVALID_ARGUMENT for an unknown routine */
+    int (*default_options)(int routine, CompiOptions* options);
+
+    /* Returns a static description of a status code */
+    const char* (*status_message)(int status);
+
+    int (*trapezoidal)(CompiIntegrand f, void* context, double a, double b,
+                       const CompiOptions* options, CompiResult* result);
+
+    /* points must be 15, 31, 41, 51 or 61 */
+    int (*gauss_kronrod)(CompiIntegrand f, void* context, double a, double b, unsigned points,
+                         const CompiOptions* options, CompiResult* result);
+
+    /* a and b may be infinite */
+    int (*tanh_sinh)(CompiIntegrand f, void* context, double a, double b,
+                     const CompiOptions* options, CompiResult* result);
+
+    /* Integrates over the whole real line */
+    int (*sinh_sinh)(CompiIntegrand f, void* context,
+                     const CompiOptions* options, CompiResult* result);
+
+    /* Integrates from b to +infinity if interval_infinity > 0, or -infinity to b if it is < 0 */
+    int (*exp_sinh)(CompiIntegrand f, void* context, double b, int interval_infinity,
+                    const CompiOptions* options, CompiResult* result);
+} CompiCAPI;
+
+#ifdef Py_PYTHON_H
+/* Imports compi and returns its C API, or NULL with an ImportError set if it cannot be
+   imported or is older than this header. Must be called with the GIL held */
+static inline const CompiCAPI* compi_import_capi(void){
+    const CompiCAPI* api = (const CompiCAPI*) PyCapsule_Import(COMPI_CAPSULE_NAME, 0);
+    if(api && api->version < COMPI_CAPI_VERSION){
+        PyErr_Format(PyExc_ImportError, "compi C API version %u is older than the required version %u",
+                     api->version, (unsigned) COMPI_CAPI_VERSION);
+        return NULL;
+    }
+    return api;
+}
+#endif
+
+#endif
@@ -0,0 +1,1003 @@
+#ifndef COMPI_ENGINES_GUARD
+#define COMPI_ENGINES_GUARD
+
+// Header only C++ library of the compi integration engines, independent of Python.
+//
+//      auto r = compi::tanh_sinh([](double x){ return std::exp(std::complex<double>(-x*x, x)); }, -1.0, 1.0);
+//      // r.result, r.err, r.l1, r.levels, r.converged, r.criterion
+//
+// Each routine is templated on the integrand, which may be any callable taking a double and
+// returning a real or complex value, so lambdas are inlined into the quadrature loops. Options
+// structs give the same defaults as the Python interface. Errors are reported by throwing:
+// std::invalid_argument for invalid options or bounds, and the boost exceptions (derived
+// from std::domain_error or std::evaluation_error) for integrands which cannot be integrated.
+// Anything thrown by the integrand propagates out of the routine unchanged.
+//
+// integrate_with_grad integrates a function of x and of N parameters together with its
+// derivatives with respect to those parameters, which are computed by evaluating the integrand
+// with the forward mode dual numbers in compi::Dual.
+//
+// tanh_sinh, sinh_sinh and exp_sinh share one copy of their abscissa and weight tables across
+// the process, which can also be memory mapped from a file generated at build time, so that
+// it is shared between processes (see compi_node_tables.hpp).
+//
+// Only requires the boost math headers. The Python extension and the C API in compi_capi.h
+// are both built on top of this library.
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <boost/math/quadrature/trapezoidal.hpp>
+#include <boost/math/quadrature/gauss_kronrod.hpp>
+#include <boost/math/quadrature/tanh_sinh.hpp>
+#include <boost/math/quadrature/exp_sinh.hpp>
+#include <boost/math/quadrature/sinh_sinh.hpp>
+#include <boost/math/policies/error_handling.hpp>
+#include <boost/math/special_functions/fpclassify.hpp>
+#include <boost/math/tools/precision.hpp>
+
+#include "compi_node_tables.hpp"
+
+namespace compi {
+
+using Real = double;
+
+// Options for tanh_sinh, sinh_sinh, exp_sinh and quad
+// Refinement stops once err <= max(atol, tolerance*|result|), or err <= tolerance*l1.
+// An atol of 0 gives the purely relative tolerance of boost
+struct Options{
+    unsigned max_levels = 15;
+    Real tolerance = boost::math::tools::root_epsilon<Real>();
+    Real atol = 0;
+};
+
+struct GaussKronrodOptions{
+    unsigned max_levels = 15;
+    Real tolerance = boost::math::tools::root_epsilon<Real>();
+    unsigned points = 31; // 15, 31, 41, 51 or 61
+    Real atol = 0;
+};
+
+struct TrapezoidalOptions{
+    unsigned max_levels = 12;
+    Real tolerance = std::numeric_limits<Real>::epsilon();
+    bool periodic = false;  // f has period b-a
+    bool romberg = false;   // apply Richardson extrapolation. Cannot be used with periodic
+    Real atol = 0;
+};
+
+template<typename T>
+struct Result{
+    T result{};
+    Real err = 0;
+    Real l1 = 0;
+    std::size_t levels = 0; // levels of refinement used, where the routine reports them
+    bool converged = false; // one of the stopping criteria was met
+    // The criterion which was met, checked in this order: "relative" (err <= tolerance*|result|),
+    // "L1 norm" (err <= tolerance*l1) or "absolute" (err <= atol). nullptr if not converged
+    const char* criterion = nullptr;
+};
+
+template<typename T>
+struct QuadResult: public Result<T>{
+    const char* method = nullptr; // name of the routine chosen by quad
+    std::size_t evaluations = 0;
+};
+
+// The type returned by the integrand F
+template<typename F>
+using value_type_t = std::decay_t<std::invoke_result_t<F&,Real>>;
+
+// Forward mode dual number, holding a value and its derivatives with respect to N real
+// parameters. T may be real or complex. Arithmetic and the usual functions (found by
+// argument dependent lookup, as for std::complex) propagate the derivatives by the chain rule.
+// For complex T the derivatives of abs, real, imag and conj, which are not holomorphic, are
+// taken with each parameter varying along the real axis.
+template<typename T, std::size_t N>
+struct Dual{
+    using value_type = T;
+    static constexpr std::size_t size = N;
+
+    T value{};
+    std::array<T,N> gradient{};
+
+    Dual() = default;
+
+    // A constant, with no dependence on the parameters
+    template<typename U, typename = std::enable_if_t<std::is_convertible<U,T>::value>>
+    Dual(const U& constant): value(constant){}
+
+    template<typename U, typename = std::enable_if_t<std::is_convertible<U,T>::value>>
+    Dual(const Dual<U,N>& other): value(other.value){
+        for(std::size_t k = 0; k < N; ++k){
+            gradient[k] = other.gradient[k];
+        }
+    }
+
+    // The k'th parameter, with the value given
+    static Dual parameter(const T& parameter_value, std::size_t k){
+        Dual d{parameter_value};
+        d.gradient[k] = 1;
+        return d;
+    }
+
+    Dual& operator+=(const Dual& other){
+        value += other.value;
+        for(std::size_t k = 0; k < N; ++k){
+            gradient[k] += other.gradient[k];
+        }
+        return *this;
+    }
+
+    Dual& operator-=(const Dual& other){
+        value -= other.value;
+        for(std::size_t k = 0; k < N; ++k){
+            gradient[k] -= other.gradient[k];
+        }
+        return *this;
+    }
+
+    Dual& operator*=(const Dual& other){
+        for(std::size_t k = 0; k < N; ++k){
+            gradient[k] = gradient[k]*other.value + value*other.gradient[k];
+        }
+        value *= other.value;
+        return *this;
+    }
+
+    Dual& operator/=(const Dual& other){
+        value /= other.value;
+        for(std::size_t k = 0; k < N; ++k){
+            gradient[k] = (gradient[k] - value*other.gradient[k])/other.value;
+        }
+        return *this;
+    }
+
+    friend Dual operator+(Dual a, const Dual& b){ return a += b; }
+    friend Dual operator-(Dual a, const Dual& b){ return a -= b; }
+    friend Dual operator*(Dual a, const Dual& b){ return a *= b; }
+    friend Dual operator/(Dual a, const Dual& b){ return a /= b; }
+    friend Dual operator+(const Dual& a){ return a; }
+    friend Dual operator-(const Dual& a){
+        Dual negated;
+        negated.value = -a.value;
+        for(std::size_t k = 0; k < N; ++k){
+            negated.gradient[k] = -a.gradient[k];
+        }
+        return negated;
+    }
+};
+
+namespace detail {
+
+// Returns g(a), given g(a.value) and g'(a.value)
+template<typename T, std::size_t N>
+Dual<T,N> chain(const Dual<T,N>& a, const T& value, const T& derivative){
+    Dual<T,N> result{value};
+    for(std::size_t k = 0; k < N; ++k){
+        result.gradient[k] = derivative*a.gradient[k];
+    }
+    return result;
+}
+
+}
+
+template<typename T, std::size_t N>
+Dual<T,N> exp(const Dual<T,N>& a){
+    using std::exp;
+    const T e = exp(a.value);
+    return detail::chain(a,e,e);
+}
+
+template<typename T, std::size_t N>
+Dual<T,N> log(const Dual<T,N>& a){
+    using std::log;
+    return detail::chain(a,log(a.value),T(1)/a.value);
+}
+
+template<typename T, std::size_t N>
+Dual<T,N> sqrt(const Dual<T,N>& a){
+    using std::sqrt;
+    const T s = sqrt(a.value);
+    return detail::chain(a,s,T(0.5)/s);
+}
+
+template<typename T, std::size_t N>
+Dual<T,N> sin(const Dual<T,N>& a){
+    using std::sin; using std::cos;
+    return detail::chain(a,sin(a.value),cos(a.value));
+}
+
+template<typename T, std::size_t N>
+Dual<T,N> cos(const Dual<T,N>& a){
+    using std::sin; using std::cos;
+    return detail::chain(a,cos(a.value),-sin(a.value));
+}
+
+template<typename T, std::size_t N>
+Dual<T,N> tan(const Dual<T,N>& a){
+    using std::tan;
+    const T t = tan(a.value);
+    return detail::chain(a,t,T(1) + t*t);
+}
+
+template<typename T, std::size_t N>
+Dual<T,N> sinh(const Dual<T,N>& a){
+    using std::sinh; using std::cosh;
+    return detail::chain(a,sinh(a.value),cosh(a.value));
+}
+
+template<typename T, std::size_t N>
+Dual<T,N> cosh(const Dual<T,N>& a){
+    using std::sinh; using std::cosh;
+    return detail::chain(a,cosh(a.value),sinh(a.value));
+}
+
+template<typename T, std::size_t N>
+Dual<T,N> tanh(const Dual<T,N>& a){
+    using std::tanh;
+    const T t = tanh(a.value);
+    return detail::chain(a,t,T(1) - t*t);
+}
+
+template<typename T, std::size_t N>
+Dual<T,N> asin(const Dual<T,N>& a){
+    using std::asin; using std::sqrt;
+    return detail::chain(a,asin(a.value),T(1)/sqrt(T(1) - a.value*a.value));
+}
+
+template<typename T, std::size_t N>
+Dual<T,N> acos(const Dual<T,N>& a){
+    using std::acos; using std::sqrt;
+    return detail::chain(a,acos(a.value),T(-1)/sqrt(T(1) - a.value*a.value));
+}
+
+template<typename T, std::size_t N>
+Dual<T,N> atan(const Dual<T,N>& a){
+    using std::atan;
+    return detail::chain(a,atan(a.value),T(1)/(T(1) + a.value*a.value));
+}
+
+template<typename T, std::size_t N>
+Dual<T,N> asinh(const Dual<T,N>& a){
+    using std::asinh; using std::sqrt;
+    return detail::chain(a,asinh(a.value),T(1)/sqrt(a.value*a.value + T(1)));
+}
+
+template<typename T, std::size_t N>
+Dual<T,N> acosh(const Dual<T,N>& a){
+    using std::acosh; using std::sqrt;
+    // Written as a product of square roots, which is correct on both sides of the branch cut
+    return detail::chain(a,acosh(a.value),T(1)/(sqrt(a.value - T(1))*sqrt(a.value + T(1))));
+}
+
+template<typename T, std::size_t N>
+Dual<T,N> atanh(const Dual<T,N>& a){
+    using std::atanh;
+    return detail::chain(a,atanh(a.value),T(1)/(T(1) - a.value*a.value));
+}
+
+template<typename T, std::size_t N>
+Dual<T,N> pow(const Dual<T,N>& a, const Dual<T,N>& b){
+    using std::pow; using std::log;
+    Dual<T,N> result{pow(a.value,b.value)};
+    const T power_derivative = b.value*pow(a.value,b.value - T(1));
+    for(std::size_t k = 0; k < N; ++k){
+        result.gradient[k] = power_derivative*a.gradient[k];
+        // Only added where needed, so that e.g. pow(0,2) does not give 0*log(0)
+        if(b.gradient[k] != T(0)){
+            result.gradient[k] += result.value*log(a.value)*b.gradient[k];
+        }
+    }
+    return result;
+}
+
+template<typename T, std::size_t N>
+Dual<T,N> pow(const Dual<T,N>& a, const typename Dual<T,N>::value_type& b){
+    return pow(a,Dual<T,N>{b});
+}
+
+template<typename T, std::size_t N>
+Dual<T,N> pow(const typename Dual<T,N>::value_type& a, const Dual<T,N>& b){
+    return pow(Dual<T,N>{a},b);
+}
+
+template<typename T, std::size_t N>
+Dual<Real,N> abs(const Dual<T,N>& a){
+    using std::abs;
+    Dual<Real,N> result{static_cast<Real>(abs(a.value))};
+    for(std::size_t k = 0; k < N; ++k){
+        result.gradient[k] = std::real(std::conj(a.value)*a.gradient[k])/result.value;
+    }
+    return result;
+}
+
+template<typename T, std::size_t N>
+Dual<Real,N> real(const Dual<T,N>& a){
+    Dual<Real,N> result{std::real(a.value)};
+    for(std::size_t k = 0; k < N; ++k){
+        result.gradient[k] = std::real(a.gradient[k]);
+    }
+    return result;
+}
+
+template<typename T, std::size_t N>
+Dual<Real,N> imag(const Dual<T,N>& a){
+    Dual<Real,N> result{std::imag(a.value)};
+    for(std::size_t k = 0; k < N; ++k){
+        result.gradient[k] = std::imag(a.gradient[k]);
+    }
+    return result;
+}
+
+template<typename T, std::size_t N>
+Dual<T,N> conj(const Dual<T,N>& a){
+    if constexpr(std::is_floating_point<T>::value){
+        return a;
+    }
+    else{
+        Dual<T,N> result{std::conj(a.value)};
+        for(std::size_t k = 0; k < N; ++k){
+            result.gradient[k] = std::conj(a.gradient[k]);
+        }
+        return result;
+    }
+}
+
+template<typename T, std::size_t N>
+struct GradientResult: public Result<T>{
+    std::array<T,N> gradient{}; // the integrals of the derivatives of f
+    const char* method = nullptr; // name of the routine used
+};
+
+namespace detail {
+
+template<typename T>
+void set_converged(Result<T>& result, Real tolerance, Real atol) noexcept{
+    using std::abs;
+    if(result.err <= tolerance*abs(result.result)){
+        result.criterion = "relative";
+    }
+    else if(result.err <= tolerance*result.l1){
+        result.criterion = "L1 norm";
+    }
+    else if(result.err <= atol){
+        result.criterion = "absolute";
+    }
+    else{
+        result.criterion = nullptr;
+    }
+    result.converged = result.criterion != nullptr;
+}
+
+// Trapezoidal quadrature over nested grids, where each level reuses all the
+// evaluations of the level before it and only evaluates f at the new midpoints.
+// The refinement follows boost::math::quadrature::trapezoidal, but the stopping
+// criterion depends on the mode:
+//      plain (neither periodic nor romberg): the error is the change between the last two
+//      levels, as in boost, but refinement also stops once it is below options.atol
+//      periodic: f is assumed to have period b-a, so f(b) is not evaluated and,
+//      since the error then decreases exponentially, the error of the current level
+//      is estimated as the square of the relative change between the last two levels
+//      romberg: Richardson extrapolation is applied to the sequence of estimates and
+//      refinement stops when consecutive diagonal elements of the Romberg table agree
+template<typename F>
+Result<value_type_t<F>> nested_trapezoidal(F& f, Real a, Real b, const TrapezoidalOptions& options){
+    using std::abs;
+    using K = value_type_t<F>;
+    static const char* function = "nested_trapezoidal<%1%>(F, %1%, %1%)";
+
+    Result<K> result;
+
+    if(!(boost::math::isfinite)(a)){
+        result.result = boost::math::policies::raise_domain_error(function, "Left endpoint of integration must be finite for trapezoidal integration but got a = %1%.\n", a, boost::math::policies::policy<>());
+        return result;
+    }
+    if(!(boost::math::isfinite)(b)){
+        result.result = boost::math::policies::raise_domain_error(function, "Right endpoint of integration must be finite for trapezoidal integration but got b = %1%.\n", b, boost::math::policies::policy<>());
+        return result;
+    }
+    if(a == b){
+        return result;
+    }
+    if(a > b){
+        result = nested_trapezoidal(f, b, a, options);
+        result.result = -result.result;
+        return result;
+    }
+
+    const K ya = f(a);
+    const K yb = options.periodic ? ya : f(b);
+    Real h = (b - a)/2;
+    K I = (ya + yb)*h;
+    Real IL = (abs(ya) + abs(yb))*h;
+
+    // Row of the Romberg table for the previous level. Only the diagonal
+    // element is used in periodic mode
+    std::vector<K> romberg_row{I};
+    Real error = std::numeric_limits<Real>::infinity();
+    Real last_error = error;
+
+    // As in boost, at least 5 levels are used so that features of f are not missed
+    std::size_t k = 1;
+    for(; k < 5 || k < options.max_levels; ++k){
+        const std::size_t p = static_cast<std::size_t>(1u) << k;
+        K sum = 0;
+        Real absum = 0;
+        for(std::size_t j = 1; j < p; j += 2){
+            const K y = f(a + j*h);
+            sum += y;
+            absum += abs(y);
+        }
+        const K I_last = I;
+        I = I*static_cast<Real>(0.5) + sum*h;
+        IL = IL/2 + absum*h;
+        h /= 2;
+
+        if(options.romberg){
+            std::vector<K> row{I};
+            row.reserve(k+1);
+            Real factor = 1;
+            for(std::size_t m = 1; m <= k; ++m){
+                factor *= 4;
+                row.push_back(row[m-1] + (row[m-1] - romberg_row[m-1])/(factor - 1));
+            }
+            last_error = error;
+            error = abs(row.back() - romberg_row.back());
+            romberg_row = std::move(row);
+
+            if(k >= 4){
+                if(error <= options.tolerance*IL || error <= options.atol){
+                    break;
+                }
+                // Once the table has converged to within rounding error further
+                // levels only add noise, so refinement is stopped
+                if(error > last_error && error <= boost::math::tools::root_epsilon<Real>()*IL){
+                    break;
+                }
+            }
+        }
+        else if(options.periodic){
+            // The squared estimate only holds once the error is decreasing exponentially, which
+            // is taken to be the case when it meets the tolerance. Otherwise the change itself
+            // is reported
+            const Real change = abs(I - I_last);
+            const Real squared_error = IL > 0 ? change*change/IL : change;
+            if(k >= 4 && (squared_error <= options.tolerance*IL || squared_error <= options.atol)){
+                error = squared_error;
+                break;
+            }
+            error = change;
+        }
+        else{
+            error = abs(I - I_last);
+            if(k >= 4 && (error <= options.tolerance*IL || error <= options.atol)){
+                break;
+            }
+        }
+
+        if(std::isnan(std::real(I)) || std::isnan(std::imag(I))){
+            result.result = boost::math::policies::raise_evaluation_error(function, "The trapezoidal rule encountered a NaN at a = %1%.\n", a, boost::math::policies::policy<>());
+            return result;
+        }
+    }
+
+    result.result = options.romberg ? romberg_row.back() : I;
+    result.err = error;
+    result.l1 = IL;
+    result.levels = k;
+    return result;
+}
+
+// A single Points point Gauss-Kronrod rule over [a,b]
+template<unsigned Points, typename F>
+Result<value_type_t<F>> gauss_kronrod_rule(F& f, Real a, Real b){
+    Result<value_type_t<F>> piece;
+    piece.result = boost::math::quadrature::gauss_kronrod<Real,Points>::integrate(std::ref(f),a,b,0,0,&(piece.err),&(piece.l1));
+    return piece;
+}
+
+// Refines piece, the rule over [a,b], by the same recursive bisection as
+// boost::math::quadrature::gauss_kronrod: a piece is split in half while its error is above
+// both tolerance*|estimate| and abs_tolerance, which is halved for each half
+template<unsigned Points, typename F, typename K>
+void refine_gauss_kronrod(F& f, Real a, Real b, unsigned levels, Real tolerance, Real abs_tolerance, Result<K>& piece){
+    using std::abs;
+    if(levels == 0 || piece.err <= tolerance*abs(piece.result) || piece.err <= abs_tolerance){
+        return;
+    }
+    const Real mid = (a + b)/2;
+    Result<K> left = gauss_kronrod_rule<Points>(f,a,mid);
+    refine_gauss_kronrod<Points>(f,a,mid,levels-1,tolerance,abs_tolerance/2,left);
+    Result<K> right = gauss_kronrod_rule<Points>(f,mid,b);
+    refine_gauss_kronrod<Points>(f,mid,b,levels-1,tolerance,abs_tolerance/2,right);
+
+    piece.result = left.result + right.result;
+    piece.err = left.err + right.err;
+    piece.l1 = left.l1 + right.l1;
+}
+
+// Adaptive Gauss-Kronrod quadrature over a finite range, where the top level absolute
+// tolerance boost uses (tolerance*|estimate|) is raised to atol if that is larger
+template<unsigned Points, typename F>
+Result<value_type_t<F>> adaptive_gauss_kronrod(F& f, Real a, Real b, unsigned max_levels, Real tolerance, Real atol){
+    using std::abs;
+    Result<value_type_t<F>> result = gauss_kronrod_rule<Points>(f,a,b);
+    refine_gauss_kronrod<Points>(f,a,b,max_levels,tolerance,std::max(tolerance*abs(result.result),atol),result);
+    return result;
+}
+
+// boost::math::quadrature::gauss_kronrod with an absolute tolerance. Infinite ranges are
+// mapped onto finite ones by the same changes of variable as boost
+template<unsigned Points, typename F>
+Result<value_type_t<F>> gauss_kronrod_with_atol(F& f, Real a, Real b, const GaussKronrodOptions& options){
+    using K = value_type_t<F>;
+
+    if(std::isnan(a) || std::isnan(b)){
+        throw std::invalid_argument("The limits of integration cannot be nan");
+    }
+    if(a == b){
+        return Result<K>{};
+    }
+    if(a > b){
+        Result<K> result = gauss_kronrod_with_atol<Points>(f,b,a,options);
+        result.result = -result.result;
+        return result;
+    }
+
+    if(std::isinf(a) && std::isinf(b)){
+        auto u = [&f](Real t){
+            const Real inv = 1/(1 - t*t);
+            return f(t*inv)*((1 + t*t)*inv*inv);
+        };
+        return adaptive_gauss_kronrod<Points>(u,-1,1,options.max_levels,options.tolerance,options.atol);
+    }
+    if(std::isinf(a) || std::isinf(b)){
+        // The range [0,oo) from the finite end is mapped onto (-1,1], with a factor of 2 taken
+        // out of the integral, so atol is halved
+        const Real sign = std::isinf(b) ? 1 : -1;
+        const Real end = std::isinf(b) ? a : b;
+        auto u = [&f,sign,end](Real t){
+            const Real z = 1/(t + 1);
+            return f(end + sign*(2*z - 1))*(z*z);
+        };
+        Result<K> result = adaptive_gauss_kronrod<Points>(u,-1,1,options.max_levels,options.tolerance,options.atol/2);
+        result.result *= 2;
+        result.err *= 2;
+        result.l1 *= 2;
+        return result;
+    }
+    return adaptive_gauss_kronrod<Points>(f,a,b,options.max_levels,options.tolerance,options.atol);
+}
+
+template<unsigned Points, typename F>
+Result<value_type_t<F>> gauss_kronrod(F& f, Real a, Real b, const GaussKronrodOptions& options){
+    if(options.atol > 0){
+        return gauss_kronrod_with_atol<Points>(f,a,b,options);
+    }
+    Result<value_type_t<F>> result;
+    result.result = boost::math::quadrature::gauss_kronrod<Real,Points>::integrate(f,a,b,options.max_levels,options.tolerance,&(result.err),&(result.l1));
+    return result;
+}
+
+// Returns an Integrator (e.g. boost::math::quadrature::tanh_sinh<Real,DoubleExponentialPolicy>)
+// with max_levels refinements. With the shared node tables an integrator costs nothing to
+// construct. Otherwise each integrator generates its own tables, so one is kept for each value
+// of max_levels, and copies of it, which share its tables, are returned. Safe to call from
+// multiple threads, as the boost integrators guard the lazy extension of their tables.
+template<typename Integrator>
+Integrator double_exponential_integrator(std::size_t max_levels){
+    #if COMPI_SHARED_NODE_TABLES
+        return Integrator(max_levels);
+    #else
+        static std::mutex cache_mutex;
+        static std::unordered_map<std::size_t,Integrator> cache;
+
+        std::lock_guard<std::mutex> lock{cache_mutex};
+        auto it = cache.find(max_levels);
+        if(it == cache.end()){
+            it = cache.emplace(max_levels,Integrator(max_levels)).first;
+        }
+        return it->second;
+    #endif
+}
+
+// Runs one of the double exponential integrators, which only stop once
+// err <= tolerance*l1, so that it also stops once err <= options.atol. The first 4 levels,
+// which boost always uses, are integrated on their own to estimate l1. If they have not
+// converged the integration is continued with the tolerance raised to atol/l1, where that is
+// larger. The evaluations of f are memoised, so the abscissas of the first levels, which are
+// shared by every level, are not evaluated again.
+// integrate(integrator, g, tolerance, result) integrates g with integrator, filling in result.
+// scale is the factor by which the integrator scales the integral over its native range,
+// which the levels recorded in finished_estimate are scaled by in the same way.
+template<typename Integrator, typename F, typename Integrate>
+Result<value_type_t<F>> double_exponential(F& f, const Options& options, Integrate integrate, Real scale = 1){
+    using K = value_type_t<F>;
+
+    finished_estimate<K>().scale = scale;
+
+    Result<K> result;
+    if(!(options.atol > 0)){
+        auto integrator = double_exponential_integrator<Integrator>(options.max_levels);
+        integrate(integrator,f,options.tolerance,result);
+        set_converged(result,options.tolerance,options.atol);
+        return result;
+    }
+
+    std::unordered_map<Real,K> evaluations;
+    auto memoised_f = [&f,&evaluations](Real x){
+        auto it = evaluations.find(x);
+        if(it == evaluations.end()){
+            it = evaluations.emplace(x,f(x)).first;
+        }
+        return it->second;
+    };
+
+    constexpr unsigned first_levels = 4;
+    auto first_integrator = double_exponential_integrator<Integrator>(std::min(options.max_levels,first_levels));
+    integrate(first_integrator,std::ref(memoised_f),options.tolerance,result);
+    set_converged(result,options.tolerance,options.atol);
+    if(result.converged || options.max_levels <= first_levels){
+        return result;
+    }
+
+    const Real tolerance = result.l1 > 0 ? std::max(options.tolerance,options.atol/result.l1) : options.tolerance;
+    result = Result<K>{};
+    auto integrator = double_exponential_integrator<Integrator>(options.max_levels);
+    integrate(integrator,std::ref(memoised_f),tolerance,result);
+    set_converged(result,options.tolerance,options.atol);
+    return result;
+}
+
+// The factor by which boost's tanh_sinh scales the integral over (-1,1), onto which it maps the
+// range, to give the integral from a to b
+inline Real tanh_sinh_scale(Real a, Real b){
+    const Real sign = a < b ? 1 : -1;
+    if(std::isfinite(a) && std::isfinite(b)){
+        return (b - a)/2;
+    }
+    if(std::isfinite(a) || std::isfinite(b)){
+        return 2*sign;
+    }
+    return sign;
+}
+
+// Checks for an integrable singularity (or a very sharp peak) at end, by sampling f
+// at two points approaching it from inside the range. A smooth integrand barely changes
+// between them, whereas one which diverges grows by orders of magnitude. typical_size
+// is the mean absolute value of f over the range, so that steep but negligibly small
+// features are ignored.
+template<typename F>
+bool endpoint_singular(F& f, Real end, Real width, Real typical_size){
+    using std::abs;
+    const Real outer = abs(f(end + static_cast<Real>(1e-4)*width));
+    const Real inner = abs(f(end + static_cast<Real>(1e-8)*width));
+    return !std::isfinite(inner) || inner > static_cast<Real>(1.5)*outer + typical_size;
+}
+
+// The value and all the derivatives of a Dual, as a vector which the boost integrators can
+// integrate in a single pass. Its abs is the euclidean norm over every component, so that the
+// error estimate and stopping criterion of the integrator apply to all of them jointly.
+template<typename T, std::size_t M>
+struct JointValue{
+    std::array<T,M> components{};
+
+    JointValue() = default;
+    JointValue(int zero){
+        components.fill(T(zero));
+    }
+    template<std::size_t N, typename = std::enable_if_t<N+1 == M>>
+    explicit JointValue(const Dual<T,N>& d){
+        components[0] = d.value;
+        for(std::size_t k = 0; k < N; ++k){
+            components[k+1] = d.gradient[k];
+        }
+    }
+
+    JointValue& operator+=(const JointValue& other){
+        for(std::size_t i = 0; i < M; ++i){
+            components[i] += other.components[i];
+        }
+        return *this;
+    }
+    JointValue& operator-=(const JointValue& other){
+        for(std::size_t i = 0; i < M; ++i){
+            components[i] -= other.components[i];
+        }
+        return *this;
+    }
+    JointValue& operator*=(Real scale){
+        for(auto& c: components){
+            c *= scale;
+        }
+        return *this;
+    }
+
+    friend JointValue operator+(JointValue a, const JointValue& b){ return a += b; }
+    friend JointValue operator-(JointValue a, const JointValue& b){ return a -= b; }
+    friend JointValue operator-(JointValue a){ return a *= -1; }
+    friend JointValue operator*(JointValue a, Real scale){ return a *= scale; }
+    friend JointValue operator*(Real scale, JointValue a){ return a *= scale; }
+
+    friend Real abs(const JointValue& a){
+        Real squared_norm = 0;
+        for(const auto& c: a.components){
+            squared_norm += std::norm(c);
+        }
+        return std::sqrt(squared_norm);
+    }
+
+    // Used by boost when reporting errors
+    friend std::ostream& operator<<(std::ostream& os, const JointValue& a){
+        return os << a.components[0];
+    }
+};
+
+}
+
+template<typename F>
+Result<value_type_t<F>> trapezoidal(F f, Real a, Real b, const TrapezoidalOptions& options = {}){
+    if(options.periodic && options.romberg){
+        throw std::invalid_argument("periodic and romberg cannot both be used in the same integration");
+    }
+
+    // boost has no absolute tolerance, so the nested grids are used whenever one is given
+    Result<value_type_t<F>> result;
+    if(options.periodic || options.romberg || options.atol > 0){
+        result = detail::nested_trapezoidal(f,a,b,options);
+    }
+    else{
+        result.result = boost::math::quadrature::trapezoidal(f,a,b,options.tolerance,options.max_levels,&(result.err),&(result.l1));
+    }
+    detail::set_converged(result,options.tolerance,options.atol);
+    return result;
+}
+
+template<typename F>
+Result<value_type_t<F>> gauss_kronrod(F f, Real a, Real b, const GaussKronrodOptions& options = {}){
+    Result<value_type_t<F>> result;
+    switch(options.points){
+        case 15:
+            result = detail::gauss_kronrod<15>(f,a,b,options);
+            break;
+        case 31:
+            result = detail::gauss_kronrod<31>(f,a,b,options);
+            break;
+        case 41:
+            result = detail::gauss_kronrod<41>(f,a,b,options);
+            break;
+        case 51:
+            result = detail::gauss_kronrod<51>(f,a,b,options);
+            break;
+        case 61:
+            result = detail::gauss_kronrod<61>(f,a,b,options);
+            break;
+        default:
+            throw std::invalid_argument("Invalid number of points for gauss_kronrod");
+    }
+    detail::set_converged(result,options.tolerance,options.atol);
+    return result;
+}
+
+// a and b may be infinite
+template<typename F>
+Result<value_type_t<F>> tanh_sinh(F f, Real a, Real b, const Options& options = {}){
+    return detail::double_exponential<boost::math::quadrature::tanh_sinh<Real,detail::DoubleExponentialPolicy>>(f,options,[a,b](auto& integrator, auto g, Real tolerance, auto& result){
+        result.result = integrator.integrate(g,a,b,tolerance,&(result.err),&(result.l1),&(result.levels));
+    },detail::tanh_sinh_scale(a,b));
+}
+
+// Integrates over the whole real line
+template<typename F>
+Result<value_type_t<F>> sinh_sinh(F f, const Options& options = {}){
+    return detail::double_exponential<boost::math::quadrature::sinh_sinh<Real,detail::DoubleExponentialPolicy>>(f,options,[](auto& integrator, auto g, Real tolerance, auto& result){
+        result.result = integrator.integrate(g,tolerance,&(result.err),&(result.l1),&(result.levels));
+    });
+}
+
+// Integrates from a to b, where exactly one of a and b is infinite
+template<typename F>
+Result<value_type_t<F>> exp_sinh(F f, Real a, Real b, const Options& options = {}){
+    if(std::isinf(a) == std::isinf(b) || std::isnan(a) || std::isnan(b) || !(a < b)){
+        throw std::invalid_argument("exp_sinh requires a < b, with exactly one of them infinite");
+    }
+
+    // maps f onto the native range of the exp_sinh integrator (0,oo). This also avoids a bug
+    // in versions of boost before 1.73, where exp_sinh does not compile for complex valued
+    // functions over any other range
+    const bool positive_axis = std::isfinite(a);
+    auto f_shifted = [
+                        &f,
+                        sign=(positive_axis ? static_cast<Real>(1):static_cast<Real>(-1)),
+                        shift=(positive_axis ? a : b)
+                     ](Real x){
+                         return f(sign*x + shift);
+                     };
+    return detail::double_exponential<boost::math::quadrature::exp_sinh<Real,detail::DoubleExponentialPolicy>>(f_shifted,options,[](auto& integrator, auto g, Real tolerance, auto& result){
+        result.result = integrator.integrate(g,tolerance,&(result.err),&(result.l1),&(result.levels));
+    });
+}
+
+// Integrates from a to b, choosing the routine to use.
+//
+// Infinite and semi-infinite ranges are sent directly to sinh_sinh and exp_sinh respectively,
+// both of which cope with slow (algebraic) decay and with singularities at a finite endpoint,
+// so there is nothing for a probe to decide between.
+//
+// Finite ranges are first probed with a single 15 point Gauss-Kronrod rule, plus two samples
+// next to each endpoint. If the probe has already converged its result is returned; otherwise
+// integrands with an endpoint singularity are integrated with tanh_sinh, and for all others
+// the probe is refined by adaptive 15 point Gauss-Kronrod quadrature, so that none of its
+// evaluations are repeated. Two 15 point rules over the halves of a range cost about as much as
+// one 31 point rule over it, so the probe is refined by up to max_levels + 1 levels, which
+// allows as many evaluations as adaptive 31 point quadrature with max_levels.
+//
+// If b < a the integral from b to a is negated.
+template<typename F>
+QuadResult<value_type_t<F>> quad(F f, Real a, Real b, const Options& options = {}){
+    using K = value_type_t<F>;
+
+    if(std::isnan(a) || std::isnan(b)){
+        throw std::invalid_argument("The limits of integration cannot be nan");
+    }
+
+    QuadResult<K> result;
+    if(a == b){
+        result.method = "none";
+        result.converged = true;
+        result.criterion = "relative";
+        return result;
+    }
+    if(a > b){
+        result = quad(f,b,a,options);
+        result.result = -result.result;
+        return result;
+    }
+
+    // The integrators take f by value, so the count is kept outside of the lambda
+    std::size_t evaluations = 0;
+    auto counted_f = [&f, &evaluations](Real x){
+        ++evaluations;
+        return f(x);
+    };
+
+    auto choose_result = [&](const Result<K>& chosen, const char* method){
+        static_cast<Result<K>&>(result) = chosen;
+        result.method = method;
+        result.evaluations = evaluations;
+        return result;
+    };
+
+    // If f throws part way through, the estimates recorded in finished_estimate are those of
+    // the routine named here
+    auto start_method = [](const char* method){
+        detail::finished_estimate<K>() = detail::FinishedEstimate<K>{};
+        detail::finished_estimate<K>().method = method;
+    };
+
+    if(std::isinf(a) && std::isinf(b)){
+        start_method("sinh_sinh");
+        return choose_result(sinh_sinh(std::ref(counted_f),options),"sinh_sinh");
+    }
+    if(std::isinf(a) || std::isinf(b)){
+        start_method("exp_sinh");
+        return choose_result(exp_sinh(std::ref(counted_f),a,b,options),"exp_sinh");
+    }
+
+    const Real width = b - a;
+    Result<K> probe = detail::gauss_kronrod_rule<15>(counted_f,a,b);
+    detail::set_converged(probe,options.tolerance,options.atol);
+
+    const Real typical_size = probe.l1/width;
+    const bool singular = detail::endpoint_singular(counted_f,a,width,typical_size) || detail::endpoint_singular(counted_f,b,-width,typical_size);
+
+    if(!singular && probe.converged){
+        return choose_result(probe,"gauss_kronrod");
+    }
+    if(singular){
+        start_method("tanh_sinh");
+        return choose_result(tanh_sinh(std::ref(counted_f),a,b,options),"tanh_sinh");
+    }
+    // The probe is the estimate to fall back on if f throws during the refinement
+    start_method("gauss_kronrod");
+    detail::record_finished_estimate(probe.result,probe.err,probe.l1,0);
+    using std::abs;
+    detail::refine_gauss_kronrod<15>(counted_f,a,b,options.max_levels + 1,options.tolerance,std::max(options.tolerance*abs(probe.result),options.atol),probe);
+    detail::set_converged(probe,options.tolerance,options.atol);
+    return choose_result(probe,"gauss_kronrod");
+}
+
+// Integrates f from a to b, where f(x) returns a Dual<T,N>, giving the integral of its value and
+// of each of its N derivatives. These are integrated together in the same refinement, so every
+// derivative costs no extra evaluations of f, with the error estimate (err) and L1 norm (l1)
+// those of the vector of all N+1 integrals. converged is true if err <= tolerance*l1, so
+// derivatives much smaller than the value are known less precisely, relative to their size.
+//
+// Finite ranges are integrated with tanh_sinh, semi-infinite ranges with exp_sinh and infinite
+// ranges with sinh_sinh. If b < a the integral from b to a is negated.
+template<typename F>
+GradientResult<typename value_type_t<F>::value_type,value_type_t<F>::size> integrate_with_grad(F f, Real a, Real b, const Options& options = {}){
+    using D = value_type_t<F>;
+    using T = typename D::value_type;
+    constexpr std::size_t N = D::size;
+    using Joint = detail::JointValue<T,N+1>;
+
+    if(std::isnan(a) || std::isnan(b)){
+        throw std::invalid_argument("The limits of integration cannot be nan");
+    }
+
+    GradientResult<T,N> result;
+    if(a == b){
+        result.method = "none";
+        result.converged = true;
+        result.criterion = "relative";
+        return result;
+    }
+    if(a > b){
+        result = integrate_with_grad(f,b,a,options);
+        result.result = -result.result;
+        for(auto& derivative: result.gradient){
+            derivative = -derivative;
+        }
+        return result;
+    }
+
+    auto joint_f = [&f](Real x){
+        return Joint(f(x));
+    };
+
+    Result<Joint> joint;
+    if(std::isinf(a) && std::isinf(b)){
+        joint = sinh_sinh(std::ref(joint_f),options);
+        result.method = "sinh_sinh";
+    }
+    else if(std::isinf(a) || std::isinf(b)){
+        joint = exp_sinh(std::ref(joint_f),a,b,options);
+        result.method = "exp_sinh";
+    }
+    else{
+        joint = tanh_sinh(std::ref(joint_f),a,b,options);
+        result.method = "tanh_sinh";
+    }
+
+    result.result = joint.result.components[0];
+    for(std::size_t k = 0; k < N; ++k){
+        result.gradient[k] = joint.result.components[k+1];
+    }
+    result.err = joint.err;
+    result.l1 = joint.l1;
+    result.levels = joint.levels;
+    result.converged = joint.converged;
+    result.criterion = joint.criterion;
+    return result;
+}
+
+// Integrates f(x, p) from a to b, along with its derivatives with respect to each of the N
+// parameters, which are passed to f as p, an array of Dual<P,N> with the values given by
+// parameters. f must return a Dual<T,N>, e.g.
+//      compi::integrate_with_grad([](double x, const auto& p){ return exp(-p[0]*x*x); },
+//                                 0.0, inf, std::array<double,1>{2.0});
+template<typename F, typename P, std::size_t N>
+auto integrate_with_grad(F f, Real a, Real b, const std::array<P,N>& parameters, const Options& options = {}){
+    std::array<Dual<P,N>,N> p;
+    for(std::size_t k = 0; k < N; ++k){
+        p[k] = Dual<P,N>::parameter(parameters[k],k);
+    }
+    return integrate_with_grad([&f,&p](Real x){ return f(x,p); },a,b,options);
+}
+
+}
+#endif
@@ -0,0 +1,932 @@
+#ifndef COMPI_NODE_TABLES_GUARD
+#define COMPI_NODE_TABLES_GUARD
+
+// Abscissa and weight tables of the double exponential integrators (tanh_sinh, exp_sinh and
+// sinh_sinh), shared by every integration in the process and, through a memory mapped file,
+// between processes.
+//
+// boost keeps a private copy of the tables in each integrator object, which is extended level
+// by level as integrations need them. Here each level of each table is held once per process
+// instead, and is only materialised the first time it is used, so integrations with a low
+// max_levels never touch the higher levels. A level comes either from a file written at build
+// time by write_node_tables, if one has been loaded with load_node_tables, or is otherwise
+// generated in the process on first use. The file is mapped read only, so the operating system
+// shares its pages between every process which loads it, and only reads in the pages of the
+// levels which are used. Each level starts on a new page for this reason.
+//
+// The integrators use the tables through the specialisations of the boost implementation
+// classes at the end of this file, selected by the policy SharedNodeTablesPolicy. The
+// integration loops are those of boost 1.74, and the rows are the same as boost's tables for
+// double, so results are unchanged apart from rounding. The implementation classes are not
+// part of the public interface of boost, so the specialisations are only compiled against
+// boost 1.74 (COMPI_SHARED_NODE_TABLES). With any other version DoubleExponentialPolicy is the
+// default policy, and the stock integrators are used, with their own tables.
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#if !defined(COMPI_MMAP_AVAILABLE) && (defined(__unix__) || defined(__APPLE__))
+    #define COMPI_MMAP_AVAILABLE
+#endif
+#ifdef COMPI_MMAP_AVAILABLE
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+#include <boost/math/constants/constants.hpp>
+#include <boost/math/policies/error_handling.hpp>
+#include <boost/math/quadrature/tanh_sinh.hpp>
+#include <boost/math/quadrature/exp_sinh.hpp>
+#include <boost/math/quadrature/sinh_sinh.hpp>
+#include <boost/math/special_functions/fpclassify.hpp>
+#include <boost/math/tools/precision.hpp>
+#include <boost/version.hpp>
+
+#ifndef COMPI_SHARED_NODE_TABLES
+    #if BOOST_VERSION >= 107400 && BOOST_VERSION < 107500
+        #define COMPI_SHARED_NODE_TABLES 1
+    #else
+        #define COMPI_SHARED_NODE_TABLES 0
+    #endif
+#endif
+
+namespace compi {
+
+using Real = double;
+
+// The number of levels written by write_node_tables by default, which covers the default
+// max_levels of every double exponential routine
+constexpr unsigned default_node_table_levels = 16;
+
+namespace detail {
+
+enum class NodeMethod: unsigned {tanh_sinh = 0, exp_sinh = 1, sinh_sinh = 2};
+constexpr std::size_t node_methods = 3;
+
+// Levels beyond this would not fit in memory, so the tables have a fixed number of slots
+constexpr std::size_t max_node_levels = 48;
+
+// boost tabulates the first 8 levels for double, and always uses all of them
+constexpr std::size_t tabulated_node_levels = 8;
+
+// One level of a table. For tanh_sinh, abscissas from first_complement onwards are stored as
+// x - 1, which is negative, so that points close to the ends of the range keep their precision
+struct NodeRow{
+    const Real* abscissas = nullptr;
+    const Real* weights = nullptr;
+    std::size_t size = 0;
+    std::size_t first_complement = 0;
+};
+
+struct GeneratedNodeRow{
+    std::vector<Real> abscissas;
+    std::vector<Real> weights;
+    std::size_t first_complement = 0;
+};
+
+// The nodes of the tables, computed in the floating point type L following the table generation
+// in boost. The levels boost tabulates for double extend over a slightly wider range of t than
+// those it computes at runtime, so the same ranges are used here.
+template<typename L>
+struct NodeFormulas{
+    const L half_pi = boost::math::constants::half_pi<L>();
+    // the t for which g'(t) ~ sqrt(max), as in boost
+    const L t_max_infinite = compute_t_max_infinite();
+    // tanh_sinh abscissas past t_crossover, where x = 0.5, are stored as -(1 - x)
+    const L t_crossover = compute_t_crossover();
+
+    // Calls visit(t) for each t at which a level of the table of method has a node, in order.
+    // This is cheap, as only the nodes themselves involve transcendental functions
+    template<typename Visit>
+    void for_each_t(NodeMethod method, std::size_t level, Visit visit) const{
+        const L h = std::ldexp(L(1),-static_cast<int>(level));
+        const bool tabulated = level < tabulated_node_levels;
+        switch(method){
+            case NodeMethod::tanh_sinh:{
+                const L t_max = tabulated ? 6 : 5;
+                if(level == 0){
+                    for(L t = 0; t <= t_max; t += 1){
+                        visit(t);
+                    }
+                }
+                else{
+                    for(L t = h; t < t_max; t += 2*h){
+                        visit(t);
+                    }
+                }
+                break;
+            }
+            case NodeMethod::exp_sinh:{
+                const L t_min = -6.1640625;
+                const L t_max = tabulated ? t_max_infinite : t_min + 12;
+                // the end condition is tested against the previous t, as in boost
+                const L step = level == 0 ? 1 : 2;
+                L t = t_min;
+                for(std::size_t j = 0; t + step*h < t_max; ++j){
+                    t = level == 0 ? t_min + j*h : t_min + (2*j + 1)*h;
+                    visit(t);
+                }
+                break;
+            }
+            case NodeMethod::sinh_sinh:{
+                // 0 is not included, as the integrators treat it separately
+                const L step = level == 0 ? h : 2*h;
+                for(L t = h; t < t_max_infinite; t += step){
+                    visit(t);
+                }
+                break;
+            }
+        }
+    }
+
+    bool complement(NodeMethod method, L t) const{
+        return method == NodeMethod::tanh_sinh && !(t < t_crossover);
+    }
+
+    // The abscissa and weight of the node of method at t
+    std::pair<L,L> node(NodeMethod method, L t) const{
+        using std::cosh;
+        using std::exp;
+        using std::sinh;
+        using std::tanh;
+        const L u = half_pi*sinh(t);
+        switch(method){
+            case NodeMethod::tanh_sinh:{
+                const L weight = half_pi*cosh(t)/(cosh(u)*cosh(u));
+                return {complement(method,t) ? -1/(exp(u)*cosh(u)) : tanh(u),weight};
+            }
+            case NodeMethod::exp_sinh:{
+                const L x = exp(u);
+                return {x,cosh(t)*half_pi*x};
+            }
+            case NodeMethod::sinh_sinh:
+                return {sinh(u),cosh(t)*half_pi*cosh(u)};
+        }
+        return {};
+    }
+
+private:
+    static L compute_t_max_infinite(){
+        using std::log;
+        using std::sqrt;
+        const L two_div_pi = boost::math::constants::two_div_pi<L>();
+        return log(2*two_div_pi*log(2*two_div_pi*sqrt(static_cast<L>(std::numeric_limits<Real>::max()))));
+    }
+
+    static L compute_t_crossover(){
+        using std::log;
+        using std::sqrt;
+        const L pi = boost::math::constants::pi<L>();
+        const L l = log(sqrt(L(3)));
+        return log((sqrt(4*l*l + pi*pi) + 2*l)/pi);
+    }
+};
+
+template<typename L>
+GeneratedNodeRow compute_node_row(NodeMethod method, std::size_t level){
+    const NodeFormulas<L> formulas;
+    GeneratedNodeRow row;
+    formulas.for_each_t(method,level,[&](L t){
+        const auto node = formulas.node(method,t);
+        row.abscissas.push_back(static_cast<Real>(node.first));
+        row.weights.push_back(static_cast<Real>(node.second));
+        if(method == NodeMethod::tanh_sinh && !formulas.complement(method,t)){
+            ++row.first_complement;
+        }
+    });
+    return row;
+}
+
+// The size and first_complement of a level, and its first and last nodes, which can be found
+// without generating the level, to check the rows read from a file
+struct NodeRowSample{
+    std::size_t size = 0;
+    std::size_t first_complement = 0;
+    std::array<Real,2> first{};
+    std::array<Real,2> last{};
+};
+
+template<typename L>
+NodeRowSample compute_node_row_sample(NodeMethod method, std::size_t level){
+    const NodeFormulas<L> formulas;
+    NodeRowSample sample;
+    L first_t = 0, last_t = 0;
+    formulas.for_each_t(method,level,[&](L t){
+        if(sample.size++ == 0){
+            first_t = t;
+        }
+        last_t = t;
+        if(method == NodeMethod::tanh_sinh && !formulas.complement(method,t)){
+            ++sample.first_complement;
+        }
+    });
+    if(sample.size > 0){
+        const auto first = formulas.node(method,first_t), last = formulas.node(method,last_t);
+        sample.first = {static_cast<Real>(first.first),static_cast<Real>(first.second)};
+        sample.last = {static_cast<Real>(last.first),static_cast<Real>(last.second)};
+    }
+    return sample;
+}
+
+// The tabulated levels are computed in long double and rounded, so agree with the values
+// boost tabulates, and later levels in double, as boost computes them
+inline GeneratedNodeRow generate_node_row(NodeMethod method, std::size_t level){
+    if(level < tabulated_node_levels){
+        return compute_node_row<long double>(method,level);
+    }
+    return compute_node_row<Real>(method,level);
+}
+
+inline NodeRowSample node_row_sample(NodeMethod method, std::size_t level){
+    if(level < tabulated_node_levels){
+        return compute_node_row_sample<long double>(method,level);
+    }
+    return compute_node_row_sample<Real>(method,level);
+}
+
+// Every level of every table in the process. Rows are published through atomic pointers, so
+// once a level exists reading it takes no lock.
+class NodeTables{
+public:
+    static NodeTables& instance(){
+        static NodeTables tables;
+        return tables;
+    }
+
+    NodeRow row(NodeMethod method, std::size_t level){
+        const NodeRow* row = slot(method,level).load(std::memory_order_acquire);
+        if(!row){
+            row = generate(method,level);
+        }
+        return *row;
+    }
+
+    // Maps the file at path written by write_node_tables, and uses it for every level which has
+    // not already been generated. Returns false, leaving the tables unchanged, if the file
+    // cannot be read or was not written by a matching version of compi.
+    // The file is never unmapped, and must not be modified while mapped, which
+    // write_node_tables avoids by replacing the file rather than writing into it.
+    bool load(const char* path){
+        const char* data;
+        std::size_t size;
+        #ifdef COMPI_MMAP_AVAILABLE
+            const int fd = open(path,O_RDONLY);
+            if(fd < 0){
+                return false;
+            }
+            struct stat file_status;
+            if(fstat(fd,&file_status) != 0 || file_status.st_size <= 0){
+                close(fd);
+                return false;
+            }
+            size = static_cast<std::size_t>(file_status.st_size);
+            void* mapped = mmap(nullptr,size,PROT_READ,MAP_SHARED,fd,0);
+            close(fd);
+            if(mapped == MAP_FAILED){
+                return false;
+            }
+            data = static_cast<const char*>(mapped);
+            auto release = [mapped,size]{ munmap(mapped,size); };
+        #else
+            // Without mmap the file is read into memory, which still saves generating the tables
+            std::ifstream file(path,std::ios::binary);
+            if(!file){
+                return false;
+            }
+            std::lock_guard<std::mutex> buffers_lock{mutex_};
+            auto& buffer = file_buffers_.emplace_back(std::istreambuf_iterator<char>(file),std::istreambuf_iterator<char>());
+            data = buffer.data();
+            size = buffer.size();
+            auto release = [this]{ file_buffers_.pop_back(); };
+        #endif
+
+        std::vector<NodeRow> rows;
+        if(!parse(data,size,rows)){
+            release();
+            return false;
+        }
+
+        #ifdef COMPI_MMAP_AVAILABLE
+            std::lock_guard<std::mutex> lock{mutex_};
+        #endif
+        bool used = false;
+        for(std::size_t i = 0; i < rows.size(); ++i){
+            if(!slots_[i].load(std::memory_order_relaxed)){
+                slots_[i].store(&published_.emplace_back(rows[i]),std::memory_order_release);
+                used = true;
+            }
+        }
+        if(!used){
+            release();
+        }
+        return true;
+    }
+
+    // The layout of the file:
+    //      magic, file_generation, the number of levels, then for each level and each method the
+    //      offset of its abscissas, its size and its first_complement, all as 64 bit integers.
+    //      The weights of each row follow its abscissas. Each level starts on a new page.
+    static constexpr char file_magic[8] = {'C','O','M','P','I','N','T','2'};
+    static constexpr std::size_t header_size = sizeof(file_magic) + 2*sizeof(std::uint64_t);
+    static constexpr std::size_t page_size = 4096;
+
+    // Identifies how the rows were generated, which depends on the precision of the types the
+    // levels are computed in, so that files written by a build which computes them differently
+    // are not used
+    static constexpr std::uint64_t file_generation = static_cast<std::uint64_t>(std::numeric_limits<long double>::digits) << 32
+                                                     | static_cast<std::uint64_t>(std::numeric_limits<Real>::digits) << 16
+                                                     | tabulated_node_levels;
+
+private:
+    NodeTables() = default;
+
+    std::atomic<const NodeRow*>& slot(NodeMethod method, std::size_t level){
+        if(level >= max_node_levels){
+            throw std::length_error("Too many levels of refinement for the double exponential node tables");
+        }
+        return slots_[level*node_methods + static_cast<std::size_t>(method)];
+    }
+
+    const NodeRow* generate(NodeMethod method, std::size_t level){
+        auto& row_slot = slot(method,level);
+        std::lock_guard<std::mutex> lock{mutex_};
+        // another thread may have generated the level while this one waited
+        if(const NodeRow* row = row_slot.load(std::memory_order_relaxed)){
+            return row;
+        }
+        const auto& generated = generated_.emplace_back(generate_node_row(method,level));
+        const NodeRow* row = &published_.emplace_back(NodeRow{generated.abscissas.data(),generated.weights.data(),
+                                                              generated.abscissas.size(),generated.first_complement});
+        row_slot.store(row,std::memory_order_release);
+        return row;
+    }
+
+    // Reads the directory of a file into rows, checking it was written for this build and
+    // describes rows inside the file, and that the size, first_complement and first and last
+    // nodes of every row match those of the rows generated by this build. Only a few pages of
+    // each level are read
+    static bool parse(const char* data, std::size_t size, std::vector<NodeRow>& rows){
+        std::uint64_t generation, levels;
+        if(size < header_size || std::memcmp(data,file_magic,sizeof(file_magic)) != 0){
+            return false;
+        }
+        std::memcpy(&generation,data+sizeof(file_magic),sizeof(generation));
+        std::memcpy(&levels,data+sizeof(file_magic)+sizeof(generation),sizeof(levels));
+        const std::size_t directory = header_size;
+        if(generation != file_generation || levels == 0 || levels > max_node_levels
+           || size < directory + 3*sizeof(std::uint64_t)*node_methods*levels){
+            return false;
+        }
+
+        for(std::size_t i = 0; i < node_methods*levels; ++i){
+            std::uint64_t entry[3];
+            std::memcpy(entry,data+directory+sizeof(entry)*i,sizeof(entry));
+            const std::uint64_t offset = entry[0], row_size = entry[1];
+            if(offset % alignof(Real) != 0 || offset > size || row_size > (size - offset)/(2*sizeof(Real)) || entry[2] > row_size){
+                return false;
+            }
+            const Real* abscissas = reinterpret_cast<const Real*>(data+offset);
+            rows.push_back(NodeRow{abscissas,abscissas+row_size,static_cast<std::size_t>(row_size),static_cast<std::size_t>(entry[2])});
+        }
+
+        for(std::size_t i = 0; i < rows.size(); ++i){
+            const NodeRow& row = rows[i];
+            const auto expected = node_row_sample(static_cast<NodeMethod>(i % node_methods),i/node_methods);
+            if(row.size != expected.size || row.first_complement != expected.first_complement){
+                return false;
+            }
+            if(row.size > 0 && !(agrees(row.abscissas[0],expected.first[0]) && agrees(row.weights[0],expected.first[1])
+                                 && agrees(row.abscissas[row.size-1],expected.last[0]) && agrees(row.weights[row.size-1],expected.last[1]))){
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static bool agrees(Real value, Real expected){
+        return std::abs(value - expected) <= 4*std::numeric_limits<Real>::epsilon()*std::abs(expected);
+    }
+
+    std::array<std::atomic<const NodeRow*>,max_node_levels*node_methods> slots_{};
+    std::mutex mutex_;
+    std::deque<GeneratedNodeRow> generated_;
+    std::deque<NodeRow> published_;
+    #ifndef COMPI_MMAP_AVAILABLE
+        std::deque<std::vector<char>> file_buffers_;
+    #endif
+};
+
+inline NodeRow node_row(NodeMethod method, std::size_t level){
+    return NodeTables::instance().row(method,level);
+}
+
+// The refinements the integrators use, given max_levels. As for boost with double, the
+// tabulated levels are always available, so max_levels is never taken as less than them
+inline std::size_t node_refinements(std::size_t max_levels){
+    return std::min(std::max(max_levels,tabulated_node_levels - 1),max_node_levels - 1);
+}
+
+// Selects the specialisations of the boost integrators which use the shared tables, e.g.
+//      boost::math::quadrature::tanh_sinh<Real,SharedNodeTablesPolicy>
+struct SharedNodeTablesPolicy: boost::math::policies::policy<>{};
+
+// The policy the engines construct the double exponential integrators with
+#if COMPI_SHARED_NODE_TABLES
+    using DoubleExponentialPolicy = SharedNodeTablesPolicy;
+#else
+    using DoubleExponentialPolicy = boost::math::policies::policy<>;
+#endif
+
+// The last estimate of an integral of type K finished by an integration in this thread. The
+// specialisations below record every level which has an error estimate as soon as it is
+// finished, so that when the integrand throws part way through a level (e.g. once an
+// evaluation budget runs out) the caller can still return the last level which was finished.
+// method is left to the caller, which names the routine if it chooses between several. The
+// stock boost integrators record nothing, so without the shared tables finished stays false.
+template<typename K>
+struct FinishedEstimate{
+    bool finished = false;
+    K result{};
+    Real err = std::numeric_limits<Real>::infinity();
+    Real l1 = 0;
+    std::size_t levels = 0;
+    const char* method = nullptr;
+    // boost scales the integral over the native range of tanh_sinh to the range asked for after
+    // integrating, so the caller sets the same factor here for the levels to be recorded with
+    Real scale = 1;
+};
+
+template<typename K>
+FinishedEstimate<K>& finished_estimate(){
+    static thread_local FinishedEstimate<K> estimate;
+    return estimate;
+}
+
+template<typename K>
+void record_finished_estimate(const K& result, Real err, Real l1, std::size_t levels){
+    FinishedEstimate<K>& estimate = finished_estimate<K>();
+    using std::abs;
+    estimate.finished = true;
+    estimate.result = estimate.scale*result;
+    estimate.err = abs(estimate.scale)*err;
+    estimate.l1 = abs(estimate.scale)*l1;
+    estimate.levels = levels;
+}
+
+}
+
+// Writes the tables for levels 0 to levels-1 to a file at path, for load_node_tables.
+// The file is written to a temporary file which then replaces path, so processes which have
+// mapped an earlier file are unaffected. Returns false if the file cannot be written
+inline bool write_node_tables(const char* path, unsigned levels = default_node_table_levels){
+    using detail::NodeTables;
+    if(levels == 0 || levels > detail::max_node_levels){
+        return false;
+    }
+
+    std::vector<detail::GeneratedNodeRow> rows;
+    for(std::size_t level = 0; level < levels; ++level){
+        for(std::size_t method = 0; method < detail::node_methods; ++method){
+            rows.push_back(detail::generate_node_row(static_cast<detail::NodeMethod>(method),level));
+        }
+    }
+
+    auto pad_to = [](std::uint64_t offset, std::uint64_t alignment){
+        return (offset + alignment - 1)/alignment*alignment;
+    };
+    std::vector<std::uint64_t> directory;
+    std::uint64_t offset = NodeTables::header_size + 3*sizeof(std::uint64_t)*rows.size();
+    for(std::size_t i = 0; i < rows.size(); ++i){
+        if(i % detail::node_methods == 0){
+            offset = pad_to(offset,NodeTables::page_size);
+        }
+        directory.insert(directory.end(),{offset,rows[i].abscissas.size(),rows[i].first_complement});
+        offset += 2*sizeof(Real)*rows[i].abscissas.size();
+    }
+
+    std::filesystem::path temporary_path{path};
+    temporary_path += ".tmp";
+    {
+        std::ofstream file(temporary_path,std::ios::binary | std::ios::trunc);
+        if(!file){
+            return false;
+        }
+        const std::uint64_t header[2] = {NodeTables::file_generation,levels};
+        std::uint64_t position = NodeTables::header_size + sizeof(std::uint64_t)*directory.size();
+        file.write(NodeTables::file_magic,sizeof(NodeTables::file_magic));
+        file.write(reinterpret_cast<const char*>(header),sizeof(header));
+        file.write(reinterpret_cast<const char*>(directory.data()),sizeof(std::uint64_t)*directory.size());
+        for(std::size_t i = 0; i < rows.size(); ++i){
+            const std::string padding(directory[3*i] - position,'\0');
+            file.write(padding.data(),padding.size());
+            file.write(reinterpret_cast<const char*>(rows[i].abscissas.data()),sizeof(Real)*rows[i].abscissas.size());
+            file.write(reinterpret_cast<const char*>(rows[i].weights.data()),sizeof(Real)*rows[i].weights.size());
+            position = directory[3*i] + 2*sizeof(Real)*rows[i].abscissas.size();
+        }
+        if(!file){
+            file.close();
+            std::error_code ignored;
+            std::filesystem::remove(temporary_path,ignored);
+            return false;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporary_path,path,error);
+    if(error){
+        std::filesystem::remove(temporary_path,error);
+        return false;
+    }
+    return true;
+}
+
+// Uses the tables in the file at path, written by write_node_tables, for every level which
+// has not yet been used in this process. Returns false if the file cannot be used, in which
+// case the tables are generated as they are needed.
+inline bool load_node_tables(const char* path){
+    return detail::NodeTables::instance().load(path);
+}
+
+}
+
+// Specialisations of the boost implementations of the double exponential integrators for
+// SharedNodeTablesPolicy, which read the rows from the shared tables. Apart from where the
+// rows come from, and each finished level being recorded with record_finished_estimate, each
+// integrate is that of boost.
+#if COMPI_SHARED_NODE_TABLES
+namespace boost { namespace math { namespace quadrature { namespace detail {
+
+template<>
+class tanh_sinh_detail<compi::Real,compi::detail::SharedNodeTablesPolicy>{
+    using Real = compi::Real;
+    using Policy = compi::detail::SharedNodeTablesPolicy;
+
+public:
+    // boost only prunes its rows for a min_complement larger than the default, which is the
+    // only value the tanh_sinh integrator is constructed with
+    tanh_sinh_detail(std::size_t max_refinements, const Real&):
+        m_max_refinements(compi::detail::node_refinements(max_refinements)){}
+
+    template<class F>
+    decltype(std::declval<F>()(std::declval<Real>(), std::declval<Real>())) integrate(const F f, Real* error, Real* L1, const char* function, Real left_min_complement, Real right_min_complement, Real tolerance, std::size_t* levels) const{
+        using std::abs;
+        using std::fabs;
+        using boost::math::constants::half;
+        using boost::math::constants::half_pi;
+        using compi::detail::NodeMethod;
+        typedef decltype(std::declval<F>()(std::declval<Real>(), std::declval<Real>())) result_type;
+
+        const compi::detail::NodeRow first_row = compi::detail::node_row(NodeMethod::tanh_sinh,0);
+
+        // The largest logical positions at which f may be evaluated without rounding onto the
+        // ends of the range (see boost)
+        std::size_t max_left_position(first_row.size - 1);
+        std::size_t max_left_index, max_right_position(max_left_position), max_right_index;
+        while (max_left_position && fabs(first_row.abscissas[max_left_position]) < left_min_complement)
+            --max_left_position;
+        while (max_right_position && fabs(first_row.abscissas[max_right_position]) < right_min_complement)
+            --max_right_position;
+
+        Real h = 1;
+        result_type I0 = half_pi<Real>()*f(0, 1);
+        Real L1_I0 = abs(I0);
+        for(std::size_t i = 1; i < first_row.size; ++i){
+            if((i > max_right_position) && (i > max_left_position))
+                break;
+            Real x = first_row.abscissas[i];
+            Real xc = x;
+            Real w = first_row.weights[i];
+            if((boost::math::signbit)(x))
+                x = 1 + xc;
+            else
+                xc = x - 1;
+            result_type yp = i <= max_right_position ? f(x, -xc) : 0;
+            result_type ym = i <= max_left_position ? f(-x, xc) : 0;
+            I0 += (yp + ym)*w;
+            L1_I0 += (abs(yp) + abs(ym))*w;
+        }
+
+        std::size_t k = 1;
+        result_type I1 = I0;
+        Real L1_I1 = L1_I0;
+        Real err = 0;
+        // counts how many times the error has increased rather than decreased
+        unsigned thrash_count = 0;
+
+        while(k < 4 || k < m_max_refinements){
+            I0 = I1;
+            L1_I0 = L1_I1;
+
+            I1 = half<Real>()*I0;
+            L1_I1 = half<Real>()*L1_I0;
+            h *= half<Real>();
+            result_type sum = 0;
+            Real absum = 0;
+            const compi::detail::NodeRow row = compi::detail::node_row(NodeMethod::tanh_sinh,k);
+
+            max_left_index = max_left_position - 1;
+            max_left_position *= 2;
+            max_right_index = max_right_position - 1;
+            max_right_position *= 2;
+            if((row.size > max_left_index + 1) && (fabs(row.abscissas[max_left_index + 1]) > left_min_complement)){
+                ++max_left_position;
+                ++max_left_index;
+            }
+            if((row.size > max_right_index + 1) && (fabs(row.abscissas[max_right_index + 1]) > right_min_complement)){
+                ++max_right_position;
+                ++max_right_index;
+            }
+
+            for(std::size_t j = 0; j < row.size; ++j){
+                if((j > max_left_index) && (j > max_right_index))
+                    break;
+                Real x = row.abscissas[j];
+                Real xc = x;
+                Real w = row.weights[j];
+                if(j >= row.first_complement)
+                    x = 1 + xc;
+                else
+                    xc = x - 1;
+
+                result_type yp = j > max_right_index ? 0 : f(x, -xc);
+                result_type ym = j > max_left_index ? 0 : f(-x, xc);
+                sum += (yp + ym)*w;
+                absum += (abs(yp) + abs(ym))*w;
+            }
+
+            I1 += sum*h;
+            L1_I1 += absum*h;
+            ++k;
+            Real last_err = err;
+            err = abs(I0 - I1);
+
+            if(!(boost::math::isfinite)(I1)){
+                return policies::raise_evaluation_error(function, "The tanh_sinh quadrature evaluated your function at a singular point and got %1%. Please narrow the bounds of integration or check your function for singularities.", I1, Policy());
+            }
+            compi::detail::record_finished_estimate(I1,err,L1_I1,k);
+            // If the error is increasing past level 4, return the result before it started to
+            if((err > last_err) && (k > 4) && (++thrash_count > 1)){
+                I1 = I0;
+                L1_I1 = L1_I0;
+                --k;
+                err = last_err;
+                break;
+            }
+            if(err <= abs(tolerance*L1_I1)){
+                break;
+            }
+        }
+
+        if(error){
+            *error = err;
+        }
+        if(L1){
+            *L1 = L1_I1;
+        }
+        if(levels){
+            *levels = k;
+        }
+        return I1;
+    }
+
+private:
+    std::size_t m_max_refinements;
+};
+
+template<>
+class exp_sinh_detail<compi::Real,compi::detail::SharedNodeTablesPolicy>{
+    using Real = compi::Real;
+    using Policy = compi::detail::SharedNodeTablesPolicy;
+
+public:
+    exp_sinh_detail(std::size_t max_refinements):
+        m_max_refinements(compi::detail::node_refinements(max_refinements)){}
+
+    template<class F>
+    auto integrate(const F& f, Real* error, Real* L1, const char* function, Real tolerance, std::size_t* levels)->decltype(std::declval<F>()(std::declval<Real>())) const{
+        typedef decltype(f(Real(0))) K;
+        using std::abs;
+        using boost::math::constants::half;
+        using compi::detail::NodeMethod;
+
+        // Two estimates of the integral to start with
+        const compi::detail::NodeRow first_row = compi::detail::node_row(NodeMethod::exp_sinh,0);
+        K I0 = 0;
+        Real L1_I0 = 0;
+        for(std::size_t i = 0; i < first_row.size; ++i){
+            K y = f(first_row.abscissas[i]);
+            I0 += y*first_row.weights[i];
+            L1_I0 += abs(y)*first_row.weights[i];
+        }
+
+        const compi::detail::NodeRow second_row = compi::detail::node_row(NodeMethod::exp_sinh,1);
+        K I1 = I0;
+        Real L1_I1 = L1_I0;
+        for(std::size_t i = 0; i < second_row.size; ++i){
+            K y = f(second_row.abscissas[i]);
+            I1 += y*second_row.weights[i];
+            L1_I1 += abs(y)*second_row.weights[i];
+        }
+
+        I1 *= half<Real>();
+        L1_I1 *= half<Real>();
+        Real err = abs(I0 - I1);
+        compi::detail::record_finished_estimate(I1,err,L1_I1,1);
+
+        std::size_t i = 2;
+        for(; i <= m_max_refinements; ++i){
+            I0 = I1;
+            L1_I0 = L1_I1;
+
+            I1 = half<Real>()*I0;
+            L1_I1 = half<Real>()*L1_I0;
+            Real h = static_cast<Real>(1)/static_cast<Real>(1 << i);
+            K sum = 0;
+            Real absum = 0;
+
+            const compi::detail::NodeRow row = compi::detail::node_row(NodeMethod::exp_sinh,i);
+            Real abterm1 = 1;
+            Real eps = tools::epsilon<Real>()*L1_I1;
+            for(std::size_t j = 0; j < row.size; ++j){
+                Real x = row.abscissas[j];
+                K y = f(x);
+                sum += y*row.weights[j];
+                Real abterm0 = abs(y)*row.weights[j];
+                absum += abterm0;
+
+                // Two consecutive terms must be negligible, in case one is at a zero of f
+                if(x > static_cast<Real>(100) && abterm0 < eps && abterm1 < eps){
+                    break;
+                }
+                abterm1 = abterm0;
+            }
+
+            I1 += sum*h;
+            L1_I1 += absum*h;
+            err = abs(I0 - I1);
+            if(!(boost::math::isfinite)(L1_I1)){
+                return static_cast<K>(policies::raise_evaluation_error(function, "The exp_sinh quadrature evaluated your function at a singular point and returned %1%. Please ensure your function evaluates to a finite number over its entire domain.", I1, Policy()));
+            }
+            compi::detail::record_finished_estimate(I1,err,L1_I1,i);
+            if(err <= tolerance*L1_I1){
+                break;
+            }
+        }
+
+        if(error){
+            *error = err;
+        }
+        if(L1){
+            *L1 = L1_I1;
+        }
+        if(levels){
+            *levels = i;
+        }
+        return I1;
+    }
+
+private:
+    std::size_t m_max_refinements;
+};
+
+template<>
+class sinh_sinh_detail<compi::Real,compi::detail::SharedNodeTablesPolicy>{
+    using Real = compi::Real;
+    using Policy = compi::detail::SharedNodeTablesPolicy;
+
+public:
+    sinh_sinh_detail(std::size_t max_refinements):
+        m_max_refinements(compi::detail::node_refinements(max_refinements)){}
+
+    template<class F>
+    auto integrate(const F f, Real tolerance, Real* error, Real* L1, std::size_t* levels)->decltype(std::declval<F>()(std::declval<Real>())) const{
+        using std::abs;
+        using boost::math::constants::half;
+        using boost::math::constants::half_pi;
+        using compi::detail::NodeMethod;
+
+        static const char* function = "boost::math::quadrature::sinh_sinh<%1%>::integrate";
+
+        typedef decltype(f(Real(0))) K;
+        K y_max = f(boost::math::tools::max_value<Real>());
+        if(abs(y_max) > boost::math::tools::epsilon<Real>()){
+            return static_cast<K>(policies::raise_domain_error(function,
+               "The function you are trying to integrate does not go to zero at infinity, and instead evaluates to %1%", y_max, Policy()));
+        }
+        K y_min = f(-boost::math::tools::max_value<Real>());
+        if(abs(y_min) > boost::math::tools::epsilon<Real>()){
+            return static_cast<K>(policies::raise_domain_error(function,
+               "The function you are trying to integrate does not go to zero at -infinity, and instead evaluates to %1%", y_max, Policy()));
+        }
+
+        // Two estimates of the integral to start with
+        const compi::detail::NodeRow first_row = compi::detail::node_row(NodeMethod::sinh_sinh,0);
+        K I0 = f(0)*half_pi<Real>();
+        Real L1_I0 = abs(I0);
+        for(std::size_t i = 0; i < first_row.size; ++i){
+            Real x = first_row.abscissas[i];
+            K yp = f(x);
+            K ym = f(-x);
+            I0 += (yp + ym)*first_row.weights[i];
+            L1_I0 += (abs(yp) + abs(ym))*first_row.weights[i];
+        }
+
+        const compi::detail::NodeRow second_row = compi::detail::node_row(NodeMethod::sinh_sinh,1);
+        K I1 = I0;
+        Real L1_I1 = L1_I0;
+        for(std::size_t i = 0; i < second_row.size; ++i){
+            Real x = second_row.abscissas[i];
+            K yp = f(x);
+            K ym = f(-x);
+            I1 += (yp + ym)*second_row.weights[i];
+            L1_I1 += (abs(yp) + abs(ym))*second_row.weights[i];
+        }
+
+        I1 *= half<Real>();
+        L1_I1 *= half<Real>();
+        Real err = abs(I0 - I1);
+        compi::detail::record_finished_estimate(I1,err,L1_I1,1);
+
+        std::size_t i = 2;
+        for(; i <= m_max_refinements; ++i){
+            I0 = I1;
+            L1_I0 = L1_I1;
+
+            I1 = half<Real>()*I0;
+            L1_I1 = half<Real>()*L1_I0;
+            Real h = static_cast<Real>(1)/static_cast<Real>(1 << i);
+            K sum = 0;
+            Real absum = 0;
+
+            Real abterm1 = 1;
+            Real eps = boost::math::tools::epsilon<Real>()*L1_I1;
+
+            const compi::detail::NodeRow row = compi::detail::node_row(NodeMethod::sinh_sinh,i);
+            for(std::size_t j = 0; j < row.size; ++j){
+                Real x = row.abscissas[j];
+                K yp = f(x);
+                K ym = f(-x);
+                sum += (yp + ym)*row.weights[j];
+                Real abterm0 = (abs(yp) + abs(ym))*row.weights[j];
+                absum += abterm0;
+
+                // Two consecutive terms must be negligible, in case one is at a zero of f
+                if(x > static_cast<Real>(100) && abterm0 < eps && abterm1 < eps){
+                    break;
+                }
+                abterm1 = abterm0;
+            }
+
+            I1 += sum*h;
+            L1_I1 += absum*h;
+            err = abs(I0 - I1);
+            if(!(boost::math::isfinite)(L1_I1)){
+                const char* err_msg = "The sinh_sinh quadrature evaluated your function at a singular point, leading to the value %1%.\n"
+                   "sinh_sinh quadrature cannot handle singularities in the domain.\n"
+                   "If you are sure your function has no singularities, please submit a bug against boost.math\n";
+                return static_cast<K>(policies::raise_evaluation_error(function, err_msg, I1, Policy()));
+            }
+            compi::detail::record_finished_estimate(I1,err,L1_I1,i);
+            if(err <= tolerance*L1_I1){
+                break;
+            }
+        }
+
+        if(error){
+            *error = err;
+        }
+        if(L1){
+            *L1 = L1_I1;
+        }
+        if(levels){
+            *levels = i;
+        }
+        return I1;
+    }
+
+private:
+    std::size_t m_max_refinements;
+};
+
+}}}}
+#endif
+
+#endif
@@ -0,0 +1,381 @@
+'''
+Process pool backend for compi
+
+Python integrands hold the GIL for every evaluation, so a single process
+cannot integrate them in parallel. IntegrationPool spawns a set of worker
+processes once, each of which receives the (pickled) integrand a single time.
+Integration tasks are then handed out through shared memory: the bounds of
+each task are written to a shared array, workers pull the index of the next
+task from a shared counter and write the result and error estimate of each
+task directly into a shared result array. Only a small control message is
+sent to each worker per batch, so no per-task pickling takes place.
+
+ThreadIntegrationPool provides the same interface using threads in a single
+process. On free-threaded builds of Python (and with the GIL disabled) the
+integrand callbacks then run concurrently, without the cost of extra processes.
+
+Requires Python 3.8 or later (multiprocessing.shared_memory)
+'''
+
+import concurrent.futures
+import math
+import multiprocessing
+from multiprocessing import resource_tracker, shared_memory
+
+import compi
+
+__all__ = ["IntegrationPool", "ThreadIntegrationPool"]
+
+# Number of bounds each routine takes before its args
+_BOUND_COUNTS = {"trapezoidal": 2,
+                 "gauss_kronrod": 2,
+                 "tanh_sinh": 2,
+                 "exp_sinh": 1,
+                 "sinh_sinh": 0,
+                 "quad": 2}
+
+# Doubles per row of the shared task and result arrays
+_TASK_WIDTH = 2
+_RESULT_WIDTH = 3 # real part, imaginary part, error
+
+_DOUBLE_SIZE = 8
+
+
+class _SharedArray:
+    '''
+    A block of shared memory viewed as a flat array of doubles
+    '''
+    def __init__(self, name=None, size=0):
+        if name is None:
+            self.shm = shared_memory.SharedMemory(create=True, size=max(size, 1)*_DOUBLE_SIZE)
+        else:
+            self.shm = shared_memory.SharedMemory(name=name)
+        self.data = self.shm.buf.cast('d')
+
+    @property
+    def name(self):
+        return self.shm.name
+
+    def __len__(self):
+        return len(self.data)
+
+    def close(self, unlink=False):
+        self.data.release()
+        self.shm.close()
+        if unlink:
+            self.shm.unlink()
+
+
+def _worker(f, args, kwargs, counter, conn):
+    '''
+    Worker process main loop. Waits for a batch descriptor, pulls tasks off
+    the shared counter until the batch is exhausted, then reports back.
+    Exits when sent None.
+    '''
+    arrays = {}
+
+    try:
+        while True:
+            batch = conn.recv()
+            if batch is None:
+                break
+            method, n_tasks, task_name, result_name, options = batch
+
+            routine = getattr(compi, method)
+            n_bounds = _BOUND_COUNTS[method]
+
+            # task and result arrays are allocated together, so are attached as a pair
+            if task_name not in arrays or result_name not in arrays:
+                for old in arrays.values():
+                    old.close()
+                arrays.clear()
+                arrays[task_name] = _SharedArray(task_name)
+                arrays[result_name] = _SharedArray(result_name)
+            tasks = arrays[task_name].data
+            results = arrays[result_name].data
+
+            error = None
+            while True:
+                with counter.get_lock():
+                    i = counter.value
+                    counter.value += 1
+                if i >= n_tasks:
+                    break
+
+                bounds = tuple(tasks[_TASK_WIDTH*i:_TASK_WIDTH*i + n_bounds])
+                try:
+                    result, err = routine(f, *bounds, args, kwargs, **options)
+                except Exception as e:
+                    error = e
+                    break
+                results[_RESULT_WIDTH*i] = result.real
+                results[_RESULT_WIDTH*i + 1] = result.imag
+                results[_RESULT_WIDTH*i + 2] = err
+
+            try:
+                conn.send(error)
+            except Exception:
+                # the exception raised by the integrand could not be pickled
+                conn.send(RuntimeError(repr(error)))
+    finally:
+        for array in arrays.values():
+            array.close()
+        conn.close()
+
+
+class _IntegrationPoolBase:
+    '''
+    Interface common to the process and thread pools. Subclasses provide the size
+    of the pool, close() and _run(method, bounds, options), which integrates over
+    each of a (validated, non-empty) list of bounds
+    '''
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc_info):
+        self.close()
+
+    def __del__(self):
+        self.close()
+
+    @property
+    def processes(self):
+        raise NotImplementedError
+
+    def close(self):
+        raise NotImplementedError
+
+    def _run(self, method, bounds, options):
+        raise NotImplementedError
+
+    def map(self, method, bounds, **options):
+        '''
+        Integrates f over each set of bounds in parallel, returning a list of (result, error) pairs
+
+        Parameters:
+            method: str. Name of the compi routine to use, e.g. "gauss_kronrod"
+            bounds: Iterable. The bounds to pass to the routine for each integral, as a tuple
+                of floats ((a, b) for finite routines, (b,) for exp_sinh and () for sinh_sinh)
+
+        Keyword Parameters:
+            Any keyword parameters accepted by the routine. full_output is not supported.
+        '''
+        if self.processes == 0:
+            raise ValueError(type(self).__name__ + " has been closed")
+        if method not in _BOUND_COUNTS:
+            raise ValueError("Unknown integration routine " + repr(method))
+        if options.get("full_output", False):
+            raise ValueError("full_output is not supported by " + type(self).__name__)
+        n_bounds = _BOUND_COUNTS[method]
+
+        bounds = [tuple(float(x) for x in b) for b in bounds]
+        for b in bounds:
+            if len(b) != n_bounds:
+                raise ValueError("{} expects {} bounds but {} were given".format(method, n_bounds, len(b)))
+        if not bounds:
+            return []
+
+        return self._run(method, bounds, options)
+
+    def subdivide(self, method, a, b, pieces=None, **options):
+        '''
+        Integrates f from a to b by splitting the range into equal subintervals, which are
+        integrated in parallel. Returns the total result and the sum of the error estimates
+
+        Parameters:
+            method: str. Name of a compi routine over a finite interval, e.g. "tanh_sinh"
+            a: float. Lower limit of integration
+            b: float. Upper limit of integration
+
+        Optional Parameters:
+            pieces: int. Number of subintervals. Default the number of processes (or threads) in the pool
+
+        Keyword Parameters:
+            Any keyword parameters accepted by the routine. full_output is not supported.
+        '''
+        if method not in _BOUND_COUNTS or _BOUND_COUNTS[method] != 2:
+            raise ValueError("subdivide requires a routine over a finite interval")
+        a, b = float(a), float(b)
+        if not (math.isfinite(a) and math.isfinite(b)):
+            raise ValueError("subdivide requires finite bounds")
+        if pieces is None:
+            pieces = self.processes
+        if pieces < 1:
+            raise ValueError("subdivide requires at least one piece")
+
+        h = (b - a)/pieces
+        edges = [a + i*h for i in range(pieces)] + [b]
+        results = self.map(method, zip(edges[:-1], edges[1:]), **options)
+        return sum(r for r, _ in results), sum(e for _, e in results)
+
+
+class IntegrationPool(_IntegrationPoolBase):
+    '''
+    A pool of worker processes which integrate a fixed Python integrand
+
+    Parameters:
+        f: Callable. Function to be integrated, as for the other compi routines. Must be picklable
+            unless the 'fork' start method is used.
+
+    Optional Parameters:
+        args: tuple. Additional positional arguments to be passed to f. Default None.
+        kwargs: dict. Additional keyword arguments to be passed to f. Default None.
+        processes: int. Number of worker processes. Default os.cpu_count().
+        context: multiprocessing context, or the name of a start method, used to create the
+            workers. Default the multiprocessing default.
+
+    The workers are started when the pool is constructed and kept alive until close()
+    is called, or the with block using the pool exits.
+    '''
+
+    # Class level defaults, so that close() is safe if __init__ fails part way through
+    _connections = []
+    _workers = []
+    _tasks = None
+    _results = None
+
+    def __init__(self, f, args=None, kwargs=None, processes=None, context=None):
+        if not callable(f):
+            raise ValueError("Unable to create an IntegrationPool for an uncallable object")
+        if processes is None:
+            processes = multiprocessing.cpu_count()
+        if processes < 1:
+            raise ValueError("An IntegrationPool requires at least one process")
+        if context is None or isinstance(context, str):
+            context = multiprocessing.get_context(context)
+
+        # Workers must share the resource tracker of this process. Otherwise each
+        # starts its own, which tries to free the shared memory again when it exits
+        resource_tracker.ensure_running()
+
+        self._counter = context.Value('q', 0)
+        self._tasks = None
+        self._results = None
+        self._connections = []
+        self._workers = []
+
+        for _ in range(processes):
+            parent_conn, child_conn = context.Pipe()
+            worker = context.Process(target=_worker,
+                                     args=(f, args, kwargs, self._counter, child_conn),
+                                     daemon=True)
+            worker.start()
+            child_conn.close()
+            self._connections.append(parent_conn)
+            self._workers.append(worker)
+
+    @property
+    def processes(self):
+        return len(self._workers)
+
+    def close(self):
+        '''
+        Stops the worker processes and frees the shared memory used by the pool
+        '''
+        for conn in self._connections:
+            try:
+                conn.send(None)
+            except (BrokenPipeError, OSError):
+                pass
+        for worker in self._workers:
+            worker.join()
+        for conn in self._connections:
+            conn.close()
+        self._connections = []
+        self._workers = []
+        for array in (self._tasks, self._results):
+            if array is not None:
+                array.close(unlink=True)
+        self._tasks = None
+        self._results = None
+
+    def _reserve(self, n_tasks):
+        # Shared arrays are only reallocated when a batch larger than any before it is run
+        if self._tasks is None or len(self._tasks) < _TASK_WIDTH*n_tasks:
+            for array in (self._tasks, self._results):
+                if array is not None:
+                    array.close(unlink=True)
+            self._tasks = _SharedArray(size=_TASK_WIDTH*n_tasks)
+            self._results = _SharedArray(size=_RESULT_WIDTH*n_tasks)
+
+    def _run(self, method, bounds, options):
+        n_tasks = len(bounds)
+        self._reserve(n_tasks)
+        tasks = self._tasks.data
+        for i, b in enumerate(bounds):
+            for j, x in enumerate(b):
+                tasks[_TASK_WIDTH*i + j] = x
+
+        with self._counter.get_lock():
+            self._counter.value = 0
+
+        batch = (method, n_tasks, self._tasks.name, self._results.name, options)
+        for conn in self._connections:
+            conn.send(batch)
+
+        errors = [conn.recv() for conn in self._connections]
+        for error in errors:
+            if error is not None:
+                raise error
+
+        results = self._results.data
+        return [(complex(results[_RESULT_WIDTH*i], results[_RESULT_WIDTH*i + 1]), results[_RESULT_WIDTH*i + 2])
+                for i in range(n_tasks)]
+
+
+class ThreadIntegrationPool(_IntegrationPoolBase):
+    '''
+    A pool of threads which integrate a fixed Python integrand
+
+    The integrand is called concurrently from each thread, so the pool only gives a speed
+    up on free-threaded builds of Python with the GIL disabled. With the GIL enabled, or
+    for integrands which are not thread-safe, use IntegrationPool instead.
+
+    Parameters:
+        f: Callable. Function to be integrated, as for the other compi routines. Must be safe
+            to call from several threads at once.
+
+    Optional Parameters:
+        args: tuple. Additional positional arguments to be passed to f. Default None.
+        kwargs: dict. Additional keyword arguments to be passed to f. Default None.
+        threads: int. Number of threads. Default os.cpu_count().
+
+    The threads are started when the pool is constructed and kept alive until close()
+    is called, or the with block using the pool exits.
+    '''
+
+    # Class level default, so that close() is safe if __init__ fails part way through
+    _executor = None
+
+    def __init__(self, f, args=None, kwargs=None, threads=None):
+        if not callable(f):
+            raise ValueError("Unable to create a ThreadIntegrationPool for an uncallable object")
+        if threads is None:
+            threads = multiprocessing.cpu_count()
+        if threads < 1:
+            raise ValueError("A ThreadIntegrationPool requires at least one thread")
+
+        self._f = f
+        self._args = args
+        self._kwargs = kwargs
+        self._threads = threads
+        self._executor = concurrent.futures.ThreadPoolExecutor(max_workers=threads)
+
+    @property
+    def processes(self):
+        return self._threads if self._executor is not None else 0
+
+    def close(self):
+        '''
+        Stops the threads used by the pool
+        '''
+        if self._executor is not None:
+            self._executor.shutdown()
+            self._executor = None
+
+    def _run(self, method, bounds, options):
+        routine = getattr(compi, method)
+        return list(self._executor.map(
+                        lambda b: routine(self._f, *b, self._args, self._kwargs, **options),
+                        bounds))
@@ -4,18 +4,29 @@
 /* Doc strings must be C constant strings. It is therefore simplest to define them as macros */
 
 /* Module docstring */
-#define COMPI_DOCS "Provides routine to perform efficient complex valued numeric integration\n\nContains:\n\ttrapezoidal: Performs trapeziodal quadrature over a finite interval\n\tgauss_kronrod: Performs Gauss-Kronrod quadrature over a finite interval\n\ttanh_sinh: Performs tanh-sinh quadrature over a finite, semi-infinite or infinite interval\n\tsinh_sinh: Performs sinh-sinh quadrature over an infinite interval\n\texp_sinh: Performs exp-sinh quadrature over a semi-infinite interval"
+#define COMPI_DOCS "Provides routine to perform efficient complex valued numeric integration\n\nContains:\n\ttrapezoidal: Performs trapeziodal quadrature over a finite interval\n\tgauss_kronrod: Performs Gauss-Kronrod quadrature over a finite interval\n\ttanh_sinh: Performs tanh-sinh quadrature over a finite, semi-infinite or infinite interval\n\tsinh_sinh: Performs sinh-sinh quadrature over an infinite interval\n\texp_sinh: Performs exp-sinh quadrature over a semi-infinite interval\n\tquad: Integrates over any interval, choosing which of the above routines to use\n\tintegrate_with_grad: Integrates an expression along with its derivatives with respect to its parameters\n\tconfigure_cache, clear_cache, cache_info: Control an optional cache of the results of previous integrations\n\nIn place of a Python function, each routine also accepts a str containing an expression in x, e.g. \"exp(1j*w*x)/(x**2+a**2)\", with the values of any other names in the expression given by kwargs. The expression is compiled and evaluated natively, without the GIL."
 
 
 /* Function docstrings */
-#define GAUSS_KRONROD_DOCS "Performs Gauss-Kronrod quadrature, returning a complex result and a real error estimate\n\nParameters:\n\tf: Callable. Function to be integrated. Must take a point in the integration range as a float in its first argument and return a complex. Additional arguments can be passed to f via the args and kwargs parameters\n\ta: float. Lower limit of integration\n\tb: float. Upper limit of integration. Must be strictly greater than a\n\nOptional Parameters:\n\targs: tuple. Additional positional arguments to be passed to f. The position in the integration region must still be the first argument of f. default None.\n\tkwargs: dict. Additional keyword arguments to be passed to f. Default None.\n\nKeyword Parameters:\n\tfull_output: bool. If true returns a dict containing additional infomation about the integration performed, in addition to the result and error estemate. This dict contains an estimate of the L1 norm of f, a list of the abscissa used in the integration, and a list of the weights used in the integration. Default False.\n\tmax_levels: int. The maximum number of levels of adaptive quadrature to be used in the integration. Set to 0 for non-adaptive quadrature. default 15\n\ttolarence: float. The maximum relative error in the result. Should not be set too close to machine precision, Default sqrt of machine precision\n\tpoints: int. Must be chosen from {15,31,41,51,61}. Number of points being used in each level of Gaussian quadrature."
+#define GAUSS_KRONROD_DOCS "Performs Gauss-Kronrod quadrature, returning a complex result and a real error estimate\n\nParameters:\n\tf: Callable. Function to be integrated. Must take a point in the integration range as a float in its first argument and return a complex. Additional arguments can be passed to f via the args and kwargs parameters\n\ta: float. Lower limit of integration\n\tb: float. Upper limit of integration. Must be strictly greater than a\n\nOptional Parameters:\n\targs: tuple. Additional positional arguments to be passed to f. The position in the integration region must still be the first argument of f. default None.\n\tkwargs: dict. Additional keyword arguments to be passed to f. Default None.\n\nKeyword Parameters:\n\tfull_output: bool. If true returns a dict containing additional infomation about the integration performed, in addition to the result and error estemate. This dict contains an estimate of the L1 norm of f, a list of the abscissa used in the integration, and a list of the weights used in the integration. It also contains converged, which is True if the requested tolarence was reached, and criterion, the stopping criterion which was met: 'relative' (error <= tolarence*|result|), 'L1 norm' (error <= tolarence*L1 norm), 'absolute' (error <= atol) or None. Default False.\n\tmax_levels: int. The maximum number of levels of adaptive quadrature to be used in the integration. Set to 0 for non-adaptive quadrature. default 15\n\ttolarence: float. The maximum relative error in the result. Should not be set too close to machine precision, Default sqrt of machine precision\n\tatol: float. The maximum absolute error in the result. Refinement stops once the error estimate is below either atol or the relative tolarence, so integrals close to zero can be computed to a fixed number of decimal places. Default 0.\n\tmax_evaluations: int. The maximum number of evaluations of f. If reached, the result from the most levels of refinement which could be completed is returned and converged is False in the full_output dict (nan with an infinite error if no level could be completed). Default no limit.\n\ttimeout: float. The maximum wall clock time in seconds to spend evaluating f. Behaves as max_evaluations when reached. Default no limit.\n\tcache_key: Any marshallable object identifying f in the result cache, if it has been enabled with configure_cache. Default None, in which case expressions and Python functions are identified by their source and code. Other callables are only cached if a cache_key is given.\n\tpoints: int. Must be chosen from {15,31,41,51,61}. Number of points being used in each level of Gaussian quadrature."
 
-#define TANH_SINH_DOCS "Performs tanh-sinh quadrature, returning a complex result and a real error estimate\n\nParameters:\n\tf: Callable. Function to be integrated. Must take a point in the integration range as a float in its first argument and return a complex. Additional arguments can be passed to f via the args and kwargs parameters\n\ta: float. Lower limit of integration. May be -inf.\n\tb: float. Upper limit of integration. Must be strictly greater than a. May be +inf\n\nOptional Parameters:\n\targs: tuple. Additional positional arguments to be passed to f. The position in the integration region must still be the first argument of f. default None.\n\tkwargs: dict. Additional keyword arguments to be passed to f. Default None.\n\nKeyword Parameters:\n\tfull_output: bool. If true returns a dict containing additional infomation about the integration performed, in addition to the result and error estemate. This dict contains an estimate of the L1 norm of f and the number of levels of adaptive quadrature used to achieve the required tolarence. Default False.\n\tmax_levels: int. The maximum number of levels of adaptive quadrature to be used in the integration. Set to 0 for non-adaptive quadrature. default 15\n\ttolarence: float. The maximum relative error in the result. Should not be set too close to machine precision, Default sqrt of machine precision."
+#define TANH_SINH_DOCS "Performs tanh-sinh quadrature, returning a complex result and a real error estimate\n\nParameters:\n\tf: Callable. Function to be integrated. Must take a point in the integration range as a float in its first argument and return a complex. Additional arguments can be passed to f via the args and kwargs parameters\n\ta: float. Lower limit of integration. May be -inf.\n\tb: float. Upper limit of integration. Must be strictly greater than a. May be +inf\n\nOptional Parameters:\n\targs: tuple. Additional positional arguments to be passed to f. The position in the integration region must still be the first argument of f. default None.\n\tkwargs: dict. Additional keyword arguments to be passed to f. Default None.\n\nKeyword Parameters:\n\tfull_output: bool. If true returns a dict containing additional infomation about the integration performed, in addition to the result and error estemate. This dict contains an estimate of the L1 norm of f and the number of levels of adaptive quadrature used to achieve the required tolarence. It also contains converged, which is True if the requested tolarence was reached, and criterion, the stopping criterion which was met: 'relative' (error <= tolarence*|result|), 'L1 norm' (error <= tolarence*L1 norm), 'absolute' (error <= atol) or None. Default False.\n\tmax_levels: int. The maximum number of levels of adaptive quadrature to be used in the integration. Set to 0 for non-adaptive quadrature. default 15\n\ttolarence: float. The maximum relative error in the result. Should not be set too close to machine precision, Default sqrt of machine precision.\n\tatol: float. The maximum absolute error in the result. Refinement stops once the error estimate is below either atol or the relative tolarence, so integrals close to zero can be computed to a fixed number of decimal places. Default 0.\n\tmax_evaluations: int. The maximum number of evaluations of f. If reached, the result from the most levels of refinement which could be completed is returned and converged is False in the full_output dict (nan with an infinite error if no level could be completed). Default no limit.\n\ttimeout: float. The maximum wall clock time in seconds to spend evaluating f. Behaves as max_evaluations when reached. Default no limit.\n\tcache_key: Any marshallable object identifying f in the result cache, if it has been enabled with configure_cache. Default None, in which case expressions and Python functions are identified by their source and code. Other callables are only cached if a cache_key is given."
 
-#define SINH_SINH_DOCS "Performs sinh-sinh quadrature, returning a complex result and a real error estimate\n\nParameters:\n\tf: Callable. Function to be integrated. Must take a float in its first argument and return a complex. Additional arguments can be passed to f via the args and kwargs parameters\n\nOptional Parameters:\n\targs: tuple. Additional positional arguments to be passed to f. The position in the integration region must still be the first argument of f. default None.\n\tkwargs: dict. Additional keyword arguments to be passed to f. Default None.\n\nKeyword Parameters:\n\tfull_output: bool. If true returns a dict containing additional infomation about the integration performed, in addition to the result and error estemate. This dict contains an estimate of the L1 norm of f and the number of levels of adaptive quadrature used to achieve the required tolarence. Default False.\n\tmax_levels: int. The maximum number of levels of adaptive quadrature to be used in the integration. Set to 0 for non-adaptive quadrature. default 15\n\ttolarence: float. The maximum relative error in the result. Should not be set too close to machine precision, Default sqrt of machine precision."
+#define SINH_SINH_DOCS "Performs sinh-sinh quadrature, returning a complex result and a real error estimate\n\nParameters:\n\tf: Callable. Function to be integrated. Must take a float in its first argument and return a complex. Additional arguments can be passed to f via the args and kwargs parameters\n\nOptional Parameters:\n\targs: tuple. Additional positional arguments to be passed to f. The position in the integration region must still be the first argument of f. default None.\n\tkwargs: dict. Additional keyword arguments to be passed to f. Default None.\n\nKeyword Parameters:\n\tfull_output: bool. If true returns a dict containing additional infomation about the integration performed, in addition to the result and error estemate. This dict contains an estimate of the L1 norm of f and the number of levels of adaptive quadrature used to achieve the required tolarence. It also contains converged, which is True if the requested tolarence was reached, and criterion, the stopping criterion which was met: 'relative' (error <= tolarence*|result|), 'L1 norm' (error <= tolarence*L1 norm), 'absolute' (error <= atol) or None. Default False.\n\tmax_levels: int. The maximum number of levels of adaptive quadrature to be used in the integration. Set to 0 for non-adaptive quadrature. default 15\n\ttolarence: float. The maximum relative error in the result. Should not be set too close to machine precision, Default sqrt of machine precision.\n\tatol: float. The maximum absolute error in the result. Refinement stops once the error estimate is below either atol or the relative tolarence, so integrals close to zero can be computed to a fixed number of decimal places. Default 0.\n\tmax_evaluations: int. The maximum number of evaluations of f. If reached, the result from the most levels of refinement which could be completed is returned and converged is False in the full_output dict (nan with an infinite error if no level could be completed). Default no limit.\n\ttimeout: float. The maximum wall clock time in seconds to spend evaluating f. Behaves as max_evaluations when reached. Default no limit.\n\tcache_key: Any marshallable object identifying f in the result cache, if it has been enabled with configure_cache. Default None, in which case expressions and Python functions are identified by their source and code. Other callables are only cached if a cache_key is given."
 
-#define EXP_SINH_DOCS "Performs exp-sinh quadrature, returning a complex result and a real error estimate\n\nParameters:\n\tf: Callable. Function to be integrated. Must take a point in the integration range as a float in its first argument and return a complex. Additional arguments can be passed to f via the args and kwargs parameters\n\tb: float. Boundry of the range of integration. Whether it is the upper or lower boundry depends on the sign of interval_infinity\n\nOptional Parameters:\n\targs: tuple. Additional positional arguments to be passed to f. The position in the integration region must still be the first argument of f. default None.\n\tkwargs: dict. Additional keyword arguments to be passed to f. Default None.\n\tinterval_infinity: float. Determines whether the range of integration is taken as b to +infinity or -infinity to b. If interval_infinity > 0 the range of integration is taken as going from b to +infinity. If interval_infinity < 0 the range -infinity to b is taken. interval_infinity == 0 raises a ValueError. Default 1.0\n\nKeyword Parameters:\n\tfull_output: bool. If true returns a dict containing additional infomation about the integration performed, in addition to the result and error estemate. This dict contains an estimate of the L1 norm of f and the number of levels of adaptive quadrature used to achieve the required tolarence. Default False.\n\tmax_levels: int. The maximum number of levels of adaptive quadrature to be used in the integration. Set to 0 for non-adaptive quadrature. default 15\n\ttolarence: float. The maximum relative error in the result. Should not be set too close to machine precision, Default sqrt of machine precision."
+#define EXP_SINH_DOCS "Performs exp-sinh quadrature, returning a complex result and a real error estimate\n\nParameters:\n\tf: Callable. Function to be integrated. Must take a point in the integration range as a float in its first argument and return a complex. Additional arguments can be passed to f via the args and kwargs parameters\n\tb: float. Boundry of the range of integration. Whether it is the upper or lower boundry depends on the sign of interval_infinity\n\nOptional Parameters:\n\targs: tuple. Additional positional arguments to be passed to f. The position in the integration region must still be the first argument of f. default None.\n\tkwargs: dict. Additional keyword arguments to be passed to f. Default None.\n\tinterval_infinity: float. Determines whether the range of integration is taken as b to +infinity or -infinity to b. If interval_infinity > 0 the range of integration is taken as going from b to +infinity. If interval_infinity < 0 the range -infinity to b is taken. interval_infinity == 0 raises a ValueError. Default 1.0\n\nKeyword Parameters:\n\tfull_output: bool. If true returns a dict containing additional infomation about the integration performed, in addition to the result and error estemate. This dict contains an estimate of the L1 norm of f and the number of levels of adaptive quadrature used to achieve the required tolarence. It also contains converged, which is True if the requested tolarence was reached, and criterion, the stopping criterion which was met: 'relative' (error <= tolarence*|result|), 'L1 norm' (error <= tolarence*L1 norm), 'absolute' (error <= atol) or None. Default False.\n\tmax_levels: int. The maximum number of levels of adaptive quadrature to be used in the integration. Set to 0 for non-adaptive quadrature. default 15\n\ttolarence: float. The maximum relative error in the result. Should not be set too close to machine precision, Default sqrt of machine precision.\n\tatol: float. The maximum absolute error in the result. Refinement stops once the error estimate is below either atol or the relative tolarence, so integrals close to zero can be computed to a fixed number of decimal places. Default 0.\n\tmax_evaluations: int. The maximum number of evaluations of f. If reached, the result from the most levels of refinement which could be completed is returned and converged is False in the full_output dict (nan with an infinite error if no level could be completed). Default no limit.\n\ttimeout: float. The maximum wall clock time in seconds to spend evaluating f. Behaves as max_evaluations when reached. Default no limit.\n\tcache_key: Any marshallable object identifying f in the result cache, if it has been enabled with configure_cache. Default None, in which case expressions and Python functions are identified by their source and code. Other callables are only cached if a cache_key is given."
 
-#define TRAPEZOIDAL_DOCS "Performs trapezoidal quadrature, returning a complex result and a real error estimate\n\nParameters:\n\tf: Callable. Function to be integrated. Must take a point in the integration range as a float in its first argument and return a complex. Additional arguments can be passed to f via the args and kwargs parameters\n\ta: float. Lower limit of integration\n\tb: float. Upper limit of integration. Must be strictly greater than a\n\nOptional Parameters:\n\targs: tuple. Additional positional arguments to be passed to f. The position in the integration region must still be the first argument of f. default None.\n\tkwargs: dict. Additional keyword arguments to be passed to f. Default None.\n\nKeyword Parameters:\n\tfull_output: bool. If true returns a dict containing additional infomation about the integration performed, in addition to the result and error estemate. This dict contains an estimate of the L1 norm of f. Default False.\n\tmax_levels: int. The maximum number of levels of adaptive quadrature to be used in the integration. Set to 0 for non-adaptive quadrature. default 12\n\ttolarence: float. The maximum relative error in the result. Should not be set too close to machine precision, Default sqrt of machine precision."
+#define QUAD_DOCS "Integrates f from a to b, automatically choosing the quadrature routine to use. Returns a complex result and a real error estimate\n\nInfinite ranges are integrated using sinh-sinh quadrature and semi-infinite ranges using exp-sinh quadrature. Over a finite range f is first integrated with a single 15 point Gauss-Kronrod rule and sampled close to each endpoint. If that has already reached the required tolarence its result is returned. Otherwise tanh-sinh quadrature is used if f appears singular at an endpoint, and adaptive Gauss-Kronrod quadrature if not.\n\nParameters:\n\tf: Callable. Function to be integrated. Must take a point in the integration range as a float in its first argument and return a complex. Additional arguments can be passed to f via the args and kwargs parameters\n\ta: float. Lower limit of integration. May be -inf or +inf.\n\tb: float. Upper limit of integration. May be -inf or +inf. If b < a the integral from b to a is negated\n\nOptional Parameters:\n\targs: tuple. Additional positional arguments to be passed to f. The position in the integration region must still be the first argument of f. default None.\n\tkwargs: dict. Additional keyword arguments to be passed to f. Default None.\n\nKeyword Parameters:\n\tfull_output: bool. If true returns a dict containing additional infomation about the integration performed, in addition to the result and error estemate. This dict contains an estimate of the L1 norm of f, the name of the method used and the total number of evaluations of f, including those made choosing the method. It also contains converged, which is True if the requested tolarence was reached, and criterion, the stopping criterion which was met: 'relative' (error <= tolarence*|result|), 'L1 norm' (error <= tolarence*L1 norm), 'absolute' (error <= atol) or None. Default False.\n\tmax_levels: int. The maximum number of levels of adaptive quadrature to be used by the chosen method. default 15\n\ttolarence: float. The maximum relative error in the result. Should not be set too close to machine precision, Default sqrt of machine precision.\n\tatol: float. The maximum absolute error in the result. Refinement stops once the error estimate is below either atol or the relative tolarence, so integrals close to zero can be computed to a fixed number of decimal places. Default 0.\n\tmax_evaluations: int. The maximum number of evaluations of f. If reached, the result from the most levels of refinement which could be completed is returned and converged is False in the full_output dict (nan with an infinite error if no level could be completed). Default no limit.\n\ttimeout: float. The maximum wall clock time in seconds to spend evaluating f. Behaves as max_evaluations when reached. Default no limit.\n\tcache_key: Any marshallable object identifying f in the result cache, if it has been enabled with configure_cache. Default None, in which case expressions and Python functions are identified by their source and code. Other callables are only cached if a cache_key is given."
+
+#define INTEGRATE_WITH_GRAD_DOCS "Integrates an expression in x from a to b along with its derivatives with respect to its parameters. Returns a complex result, a tuple of the complex integrals of the derivatives and a real error estimate\n\nThe expression is evaluated with forward mode dual numbers, so the value and every derivative are found from the same evaluations, and integrated together in a single integration. The error estimate and the L1 norm are those of the vector of the result and all of the derivatives, so derivatives much smaller than the result are known less precisely, relative to their size. Finite ranges are integrated using tanh-sinh quadrature, semi-infinite ranges using exp-sinh quadrature and infinite ranges using sinh-sinh quadrature. Derivatives with respect to a complex valued parameter are taken with the parameter varying along the real axis.\n\nParameters:\n\tf: str. Expression in x to be integrated, as for the other routines\n\ta: float. Lower limit of integration. May be -inf or +inf.\n\tb: float. Upper limit of integration. May be -inf or +inf. If b < a the integral from b to a is negated\n\tkwargs: dict. The values of the parameters of the expression\n\nOptional Parameters:\n\twrt: sequence of str. The names of the parameters to differentiate with respect to, in the order the derivatives are returned. At most 8. Default every parameter in kwargs, in order.\n\nKeyword Parameters:\n\tfull_output: bool. If true returns a dict containing additional infomation about the integration performed, in addition to the result, derivatives and error estemate. This dict contains an estimate of the L1 norm, the number of levels of adaptive quadrature used, the name of the method used, converged, which is True if the requested tolarence was reached, and criterion, the stopping criterion which was met: 'relative', 'L1 norm', 'absolute' or None. Default False.\n\tmax_levels: int. The maximum number of levels of adaptive quadrature to be used in the integration. default 15\n\ttolarence: float. The maximum relative error in the result. Should not be set too close to machine precision, Default sqrt of machine precision.\n\tatol: float. The maximum absolute error in the result. Refinement stops once the error estimate is below either atol or the relative tolarence, so integrals close to zero can be computed to a fixed number of decimal places. Default 0."
+
+#define TRAPEZOIDAL_DOCS "Performs trapezoidal quadrature, returning a complex result and a real error estimate\n\nParameters:\n\tf: Callable. Function to be integrated. Must take a point in the integration range as a float in its first argument and return a complex. Additional arguments can be passed to f via the args and kwargs parameters\n\ta: float. Lower limit of integration\n\tb: float. Upper limit of integration. Must be strictly greater than a\n\nOptional Parameters:\n\targs: tuple. Additional positional arguments to be passed to f. The position in the integration region must still be the first argument of f. default None.\n\tkwargs: dict. Additional keyword arguments to be passed to f. Default None.\n\nKeyword Parameters:\n\tfull_output: bool. If true returns a dict containing additional infomation about the integration performed, in addition to the result and error estemate. This dict contains an estimate of the L1 norm of f. It also contains converged, which is True if the requested tolarence was reached, and criterion, the stopping criterion which was met: 'relative' (error <= tolarence*|result|), 'L1 norm' (error <= tolarence*L1 norm), 'absolute' (error <= atol) or None. Default False.\n\tmax_levels: int. The maximum number of levels of adaptive quadrature to be used in the integration. Set to 0 for non-adaptive quadrature. default 12\n\ttolarence: float. The maximum relative error in the result. Should not be set too close to machine precision, Default sqrt of machine precision.\n\tatol: float. The maximum absolute error in the result. Refinement stops once the error estimate is below either atol or the relative tolarence, so integrals close to zero can be computed to a fixed number of decimal places. Default 0.\n\tmax_evaluations: int. The maximum number of evaluations of f. If reached, the result from the most levels of refinement which could be completed is returned and converged is False in the full_output dict (nan with an infinite error if no level could be completed). Default no limit.\n\ttimeout: float. The maximum wall clock time in seconds to spend evaluating f. Behaves as max_evaluations when reached. Default no limit.\n\tcache_key: Any marshallable object identifying f in the result cache, if it has been enabled with configure_cache. Default None, in which case expressions and Python functions are identified by their source and code. Other callables are only cached if a cache_key is given.\n\tperiodic: bool. If true f is assumed to be periodic with period b-a. f(b) is not evaluated and refinement stops as soon as the exponential convergence of the trapezoidal rule for periodic functions gives the required tolarence. Default False.\n\tromberg: bool. If true Richardson extrapolation is applied to the estimates from each level of refinement (Romberg integration), which converges much faster for smooth non-periodic functions. Cannot be used with periodic. Default False."
+
+/* Result cache docstrings */
+#define CONFIGURE_CACHE_DOCS "Enables, resizes or disables the cache of integration results. The cache is disabled until this is called\n\nWhen enabled, the result of each integration is stored, keyed on the routine, an identity for f, and all of the other arguments (including args, kwargs, the bounds, tolarence and max_levels). Repeating exactly the same call returns the stored result without integrating. f is identified by cache_key if given, otherwise expressions are identified by their source and Python functions by their code, defaults and the values captured by any closure. Any global variables used by a function are not part of its identity, so f must be a pure function of x, args and kwargs, or be given a cache_key which changes with its behaviour. args and kwargs must be marshallable for the call to be cached. Calls with a timeout are never cached.\n\nOptional Parameters:\n\tmaxsize: int. The maximum number of results held in memory, with the least recently used discarded first. 0 to disable the in memory cache. Default 128\n\tpath: str. A directory in which to also store results on disk, one file per result, so that they are kept between runs. Results on disk are read by memory mapping them and written atomically, so the directory may be shared by any number of processes. Created if it does not exist. Default None, for no on disk cache"
+
+#define CLEAR_CACHE_DOCS "Removes all results from the in memory cache of integration results, and resets the counts of hits and misses\n\nOptional Parameters:\n\tdisk: bool. If true also deletes all results stored on disk. Default False"
+
+#define CACHE_INFO_DOCS "Returns a dict describing the cache of integration results, containing the number of hits and misses since it was last cleared, the number of results held in memory (size), the maximum number held in memory (maxsize) and the directory used to store results on disk (path, None if not used)"
 
 #endif
\ No newline at end of file
@@ -1,10 +1,10 @@
 #include "compi.hpp"
 
 #include <array>
+#include <functional>
 #include <limits>
 
-#include <boost/version.hpp>
-#include <boost/math/quadrature/exp_sinh.hpp>
+#include "compi_engines.hpp"
 
 extern "C" {
     #include "integration_routines.h"
@@ -13,6 +13,7 @@ extern "C" {
 #include "integration_routines_template.hpp"
 
 struct ExpSinhParameters: public RoutineParametersBase {
+    static constexpr const char* name = "exp_sinh";
     Real interval_end = 0.0;
     bool positive_axis;
 
@@ -23,10 +24,10 @@ struct ExpSinhParameters: public RoutineParametersBase {
 
         float sign = 1.0;
 
-        if(!PyArg_ParseTupleAndKeywords(routine_args,routine_kwargs,"Od|OOf$pId",const_cast<char**>(keywords.data()),
+        if(!PyArg_ParseTupleAndKeywords(routine_args,routine_kwargs,"Od|OOf$pIddndO",const_cast<char**>(keywords.data()),
                 &integrand,&interval_end,
                 &args,&kw,&sign,
-                &full_output, &max_levels,&tolerance)){
+                &full_output, &max_levels,&tolerance,&atol,&max_evaluations,&timeout,&cache_key)){
             throw could_not_parse_arguments("Unable to parse python arguments to C variables");
         }
         
@@ -37,43 +38,19 @@ struct ExpSinhParameters: public RoutineParametersBase {
         positive_axis = sign > 0;
     }
 
-    struct result_type: public RoutineParametersBase::result_type {
-        size_t levels;
-    };
+    PyObject* routine_arguments() const noexcept{
+        return Py_BuildValue("(di)",interval_end,static_cast<int>(positive_axis));
+    }
 };
 
 ExpSinhParameters::result_type run_integration_routine(const compi_internal::IntegrandFunctionWrapper& f, const ExpSinhParameters& parameters){
     static_assert(std::numeric_limits<Real>::has_infinity, "Real type does not have infinity");
-    using std::complex;
-    boost::math::quadrature::exp_sinh<Real> integrator(parameters.max_levels);
-
-    ExpSinhParameters::result_type result;
-
-    // Work around bug in early versions of boost where exp_sinh.integrate will not compile when used with a complex valued function over a non-native range
-    #if BOOST_VERSION >= 107300 // bug fixed in version 1.73.00
-        Real lower_bound, upper_bound;
-        if(parameters.positive_axis){
-            lower_bound = parameters.interval_end;
-            upper_bound = std::numeric_limits<Real>::infinity();
-        }
-        else{
-            upper_bound = parameters.interval_end;
-            lower_bound = -std::numeric_limits<Real>::infinity();
-        }
-        result.result = integrator.integrate(f,lower_bound, upper_bound,parameters.tolerance,&(result.err),&(result.l1),&(result.levels));
-    #else
-        // maps the function f onto the native range of the exp_sinh integrator (0,oo)
-        auto f_shifted = [
-                            &f, 
-                            sign=(parameters.positive_axis ? static_cast<Real>(1):static_cast<Real>(-1)),
-                            shift=parameters.interval_end
-                         ](Real x){ 
-                             return f(sign*x + shift);
-                         };
+    constexpr Real infinity = std::numeric_limits<Real>::infinity();
 
-        result.result = integrator.integrate(f_shifted,parameters.tolerance,&(result.err),&(result.l1),&(result.levels));
-    #endif
-    return result;
+    if(parameters.positive_axis){
+        return compi::exp_sinh(std::cref(f),parameters.interval_end,infinity,parameters.options());
+    }
+    return compi::exp_sinh(std::cref(f),-infinity,parameters.interval_end,parameters.options());
 }
 
 extern "C" PyObject* exp_sinh(PyObject* self, PyObject* args, PyObject* kwargs){
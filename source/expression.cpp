@@ -0,0 +1,486 @@
+#include "compi.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <complex>
+#include <cstdlib>
+#include <limits>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <boost/math/constants/constants.hpp>
+
+#include "expression.hpp"
+
+namespace compi_internal {
+using std::complex;
+using OpCode = CompiledExpression::OpCode;
+
+namespace {
+
+const std::unordered_map<std::string,OpCode> functions{
+    {"exp",OpCode::exp}, {"log",OpCode::log}, {"sqrt",OpCode::sqrt},
+    {"sin",OpCode::sin}, {"cos",OpCode::cos}, {"tan",OpCode::tan},
+    {"sinh",OpCode::sinh}, {"cosh",OpCode::cosh}, {"tanh",OpCode::tanh},
+    {"asin",OpCode::asin}, {"acos",OpCode::acos}, {"atan",OpCode::atan},
+    {"asinh",OpCode::asinh}, {"acosh",OpCode::acosh}, {"atanh",OpCode::atanh},
+    {"abs",OpCode::abs}, {"conj",OpCode::conj}, {"real",OpCode::real}, {"imag",OpCode::imag}
+};
+
+const std::unordered_map<std::string,Real> named_constants{
+    {"pi",boost::math::constants::pi<Real>()},
+    {"e",boost::math::constants::e<Real>()}
+};
+
+// Integer powers up to this size are computed by repeated multiplication
+constexpr long max_integer_power = 64;
+
+// Products and quotients of real numbers are computed as real arithmetic. As well as being
+// faster, this avoids the NaN imaginary parts complex arithmetic gives with infinite values
+// (e.g. (inf+0j)*(inf+0j) == inf+nanj), which are common at the far abscissa of the infinite
+// interval routines
+inline complex<Real> multiply(const complex<Real>& a, const complex<Real>& b) noexcept{
+    if(a.imag() == 0 && b.imag() == 0){
+        return a.real()*b.real();
+    }
+    return a*b;
+}
+
+inline complex<Real> divide(const complex<Real>& a, const complex<Real>& b) noexcept{
+    if(a.imag() == 0 && b.imag() == 0){
+        return a.real()/b.real();
+    }
+    return a/b;
+}
+
+// As above, so that derivatives are also computed with real arithmetic where possible
+template<std::size_t N>
+ExpressionDual<N> multiply(const ExpressionDual<N>& a, const ExpressionDual<N>& b) noexcept{
+    ExpressionDual<N> result{multiply(a.value,b.value)};
+    for(size_t k = 0; k < N; ++k){
+        result.gradient[k] = multiply(a.value,b.gradient[k]) + multiply(a.gradient[k],b.value);
+    }
+    return result;
+}
+
+template<std::size_t N>
+ExpressionDual<N> divide(const ExpressionDual<N>& a, const ExpressionDual<N>& b) noexcept{
+    ExpressionDual<N> result{divide(a.value,b.value)};
+    for(size_t k = 0; k < N; ++k){
+        result.gradient[k] = divide(a.gradient[k] - multiply(result.value,b.gradient[k]),b.value);
+    }
+    return result;
+}
+
+template<typename Register>
+Register integer_power(Register z, std::int16_t n) noexcept{
+    const bool invert = n < 0;
+    unsigned m = static_cast<unsigned>(invert ? -n : n);
+    Register result = 1;
+    while(m){
+        if(m & 1u){
+            result = multiply(result,z);
+        }
+        m >>= 1;
+        if(m){
+            z = multiply(z,z);
+        }
+    }
+    return invert ? divide(Register(1),result) : result;
+}
+
+}
+
+// Recursive descent parser for a subset of Python expression syntax, following the Python
+// precedence rules:
+//      sum     := product (('+'|'-') product)*
+//      product := unary (('*'|'/') unary)*
+//      unary   := ('+'|'-') unary | power
+//      power   := primary ('**' unary)?
+//      primary := number | name | name '(' sum ')' | '(' sum ')'
+// While parsing, operands refer to x, a parameter, a constant or the result of an earlier
+// instruction. These are only resolved to registers at the end, once the number of
+// parameters and constants is known.
+class ExpressionParser{
+    private:
+        enum class OperandKind {x, parameter, constant, instruction};
+        struct Operand{
+            OperandKind kind;
+            size_t index;
+        };
+        struct PendingInstruction{
+            OpCode op;
+            Operand a;
+            Operand b;
+            std::int16_t exponent;
+        };
+
+        const std::string& source;
+        size_t pos = 0;
+
+        std::vector<std::string> parameters{};
+        std::vector<complex<Real>> constants{};
+        std::vector<PendingInstruction> code{};
+
+        [[noreturn]] void fail(const std::string& message) const{
+            const std::string full_message = "Invalid expression '" + source + "': " + message;
+            throw invalid_expression(full_message, full_message.c_str());
+        }
+
+        void skip_whitespace() noexcept{
+            while(pos < source.size() && std::isspace(static_cast<unsigned char>(source[pos]))){
+                ++pos;
+            }
+        }
+
+        // Consumes token if it is next in the source
+        bool accept(const char* token){
+            skip_whitespace();
+            const std::string t{token};
+            if(source.compare(pos,t.size(),t) == 0){
+                // '*' must not match the start of '**'
+                if(t == "*" && source.compare(pos,2,"**") == 0){
+                    return false;
+                }
+                pos += t.size();
+                return true;
+            }
+            return false;
+        }
+
+        void expect(const char* token){
+            if(!accept(token)){
+                fail(std::string("expected '") + token + "' at position " + std::to_string(pos));
+            }
+        }
+
+        Operand emit(OpCode op, Operand a, Operand b = {OperandKind::x,0}, std::int16_t exponent = 0){
+            code.push_back(PendingInstruction{op,a,b,exponent});
+            return Operand{OperandKind::instruction,code.size()-1};
+        }
+
+        Operand constant(complex<Real> value){
+            constants.push_back(value);
+            return Operand{OperandKind::constant,constants.size()-1};
+        }
+
+        Operand name(const std::string& id){
+            if(id == "x"){
+                return Operand{OperandKind::x,0};
+            }
+            const auto named = named_constants.find(id);
+            if(named != named_constants.end()){
+                return constant(named->second);
+            }
+            for(size_t i = 0; i < parameters.size(); ++i){
+                if(parameters[i] == id){
+                    return Operand{OperandKind::parameter,i};
+                }
+            }
+            parameters.push_back(id);
+            return Operand{OperandKind::parameter,parameters.size()-1};
+        }
+
+        Operand number(){
+            const char* start = source.c_str() + pos;
+            char* end;
+            const Real value = std::strtod(start,&end);
+            if(end == start){
+                fail("expected a number at position " + std::to_string(pos));
+            }
+            pos += static_cast<size_t>(end - start);
+            if(pos < source.size() && (source[pos] == 'j' || source[pos] == 'J')){
+                ++pos;
+                return constant(complex<Real>(0,value));
+            }
+            return constant(value);
+        }
+
+        Operand primary(){
+            skip_whitespace();
+            if(pos >= source.size()){
+                fail("unexpected end of expression");
+            }
+            const char c = source[pos];
+            if(accept("(")){
+                const Operand inner = sum();
+                expect(")");
+                return inner;
+            }
+            if(std::isdigit(static_cast<unsigned char>(c)) || c == '.'){
+                return number();
+            }
+            if(std::isalpha(static_cast<unsigned char>(c)) || c == '_'){
+                const size_t start = pos;
+                while(pos < source.size() && (std::isalnum(static_cast<unsigned char>(source[pos])) || source[pos] == '_')){
+                    ++pos;
+                }
+                const std::string id = source.substr(start,pos-start);
+
+                const auto function = functions.find(id);
+                if(function != functions.end()){
+                    expect("(");
+                    const Operand argument = sum();
+                    expect(")");
+                    return emit(function->second,argument);
+                }
+                return name(id);
+            }
+            fail(std::string("unexpected character '") + c + "' at position " + std::to_string(pos));
+        }
+
+        // Returns true, and sets n, if operand is a real integer literal small enough to be
+        // raised to by repeated multiplication
+        bool is_small_integer(Operand operand, long& n) const noexcept{
+            if(operand.kind != OperandKind::constant){
+                return false;
+            }
+            const complex<Real> value = constants[operand.index];
+            if(value.imag() != 0 || std::abs(value.real()) > max_integer_power || std::trunc(value.real()) != value.real()){
+                return false;
+            }
+            n = static_cast<long>(value.real());
+            return true;
+        }
+
+        Operand power(){
+            const Operand base = primary();
+            if(accept("**")){
+                const Operand exponent = unary();
+                long n;
+                if(is_small_integer(exponent,n)){
+                    constants.pop_back(); // the exponent is encoded in the instruction instead
+                    return emit(OpCode::integer_power,base,{OperandKind::x,0},static_cast<std::int16_t>(n));
+                }
+                return emit(OpCode::power,base,exponent);
+            }
+            return base;
+        }
+
+        Operand unary(){
+            if(accept("-")){
+                const Operand operand = unary();
+                // Negative literals are folded, so that e.g. x**-2 is an integer power
+                if(operand.kind == OperandKind::constant && operand.index == constants.size()-1){
+                    // As in Python, negating a real literal leaves its imaginary part as +0,
+                    // which matters for functions with branch cuts, e.g. sqrt(-1) == 1j
+                    const complex<Real> value = constants.back();
+                    constants.back() = complex<Real>(-value.real(), value.imag() == 0 ? value.imag() : -value.imag());
+                    return operand;
+                }
+                return emit(OpCode::negate,operand);
+            }
+            if(accept("+")){
+                return unary();
+            }
+            return power();
+        }
+
+        Operand product(){
+            Operand result = unary();
+            while(true){
+                if(accept("*")){
+                    result = emit(OpCode::multiply,result,unary());
+                } else if(accept("/")){
+                    result = emit(OpCode::divide,result,unary());
+                } else {
+                    return result;
+                }
+            }
+        }
+
+        Operand sum(){
+            Operand result = product();
+            while(true){
+                if(accept("+")){
+                    result = emit(OpCode::add,result,product());
+                } else if(accept("-")){
+                    result = emit(OpCode::subtract,result,product());
+                } else {
+                    return result;
+                }
+            }
+        }
+
+    public:
+        explicit ExpressionParser(const std::string& expression_source):source{expression_source}{}
+
+        void compile(CompiledExpression& target){
+            const Operand result = sum();
+            skip_whitespace();
+            if(pos != source.size()){
+                fail("unexpected '" + source.substr(pos) + "' at position " + std::to_string(pos));
+            }
+
+            const size_t first_instruction = 1 + parameters.size() + constants.size();
+            if(first_instruction + code.size() > std::numeric_limits<std::uint16_t>::max()){
+                fail("expression is too long");
+            }
+
+            const auto resolve = [&](Operand operand) -> std::uint16_t{
+                switch(operand.kind){
+                    case OperandKind::x:
+                        return 0;
+                    case OperandKind::parameter:
+                        return static_cast<std::uint16_t>(1 + operand.index);
+                    case OperandKind::constant:
+                        return static_cast<std::uint16_t>(1 + parameters.size() + operand.index);
+                    case OperandKind::instruction:
+                        return static_cast<std::uint16_t>(first_instruction + operand.index);
+                }
+                return 0;
+            };
+
+            target.code.reserve(code.size());
+            for(const auto& pending: code){
+                const std::uint16_t b = pending.op == OpCode::integer_power ? static_cast<std::uint16_t>(pending.exponent) : resolve(pending.b);
+                target.code.push_back(CompiledExpression::Instruction{pending.op,resolve(pending.a),b});
+            }
+            target.result_register = resolve(result);
+            target.parameters = std::move(parameters);
+            target.constants = std::move(constants);
+        }
+};
+
+CompiledExpression::CompiledExpression(const std::string& source){
+    ExpressionParser{source}.compile(*this);
+}
+
+std::vector<complex<Real>> CompiledExpression::bind_parameters(const std::unordered_map<std::string,complex<Real>>& parameter_values) const{
+    for(const auto& value: parameter_values){
+        if(std::find(parameters.cbegin(),parameters.cend(),value.first) == parameters.cend()){
+            const std::string message = "'" + value.first + "' is not a parameter of the expression";
+            throw invalid_expression(message,message.c_str());
+        }
+    }
+
+    std::vector<complex<Real>> values;
+    values.reserve(parameters.size());
+    for(const auto& name: parameters){
+        const auto value = parameter_values.find(name);
+        if(value == parameter_values.end()){
+            const std::string message = "No value given for parameter '" + name + "' of the expression";
+            throw invalid_expression(message,message.c_str());
+        }
+        values.push_back(value->second);
+    }
+    return values;
+}
+
+size_t CompiledExpression::parameter_index(const std::string& name) const{
+    const auto parameter = std::find(parameters.cbegin(),parameters.cend(),name);
+    if(parameter == parameters.cend()){
+        const std::string message = "'" + name + "' is not a parameter of the expression";
+        throw invalid_expression(message,message.c_str());
+    }
+    return static_cast<size_t>(parameter - parameters.cbegin());
+}
+
+template<typename Register>
+void CompiledExpression::initialise_registers(const std::vector<Register>& parameter_values, std::vector<Register>& registers) const{
+    registers.assign(register_count(),Register(0));
+    std::copy(parameter_values.cbegin(),parameter_values.cend(),registers.begin()+1);
+    std::copy(constants.cbegin(),constants.cend(),registers.begin()+1+parameters.size());
+}
+
+template<typename Register>
+Register CompiledExpression::evaluate(Real x, std::vector<Register>& registers) const noexcept{
+    using std::exp; using std::log; using std::sqrt; using std::pow;
+    using std::sin; using std::cos; using std::tan; using std::sinh; using std::cosh; using std::tanh;
+    using std::asin; using std::acos; using std::atan; using std::asinh; using std::acosh; using std::atanh;
+    using std::abs; using std::conj; using std::real; using std::imag;
+
+    registers[0] = x;
+    Register* out = registers.data() + 1 + parameters.size() + constants.size();
+    const Register* r = registers.data();
+
+    for(const auto& instruction: code){
+        const Register& a = r[instruction.a];
+        switch(instruction.op){
+            case OpCode::add:           *out = a + r[instruction.b]; break;
+            case OpCode::subtract:      *out = a - r[instruction.b]; break;
+            case OpCode::multiply:      *out = multiply(a,r[instruction.b]); break;
+            case OpCode::divide:        *out = divide(a,r[instruction.b]); break;
+            case OpCode::negate:        *out = -a; break;
+            case OpCode::power:         *out = pow(a,r[instruction.b]); break;
+            case OpCode::integer_power: *out = integer_power(a,static_cast<std::int16_t>(instruction.b)); break;
+            case OpCode::exp:           *out = exp(a); break;
+            case OpCode::log:           *out = log(a); break;
+            case OpCode::sqrt:          *out = sqrt(a); break;
+            case OpCode::sin:           *out = sin(a); break;
+            case OpCode::cos:           *out = cos(a); break;
+            case OpCode::tan:           *out = tan(a); break;
+            case OpCode::sinh:          *out = sinh(a); break;
+            case OpCode::cosh:          *out = cosh(a); break;
+            case OpCode::tanh:          *out = tanh(a); break;
+            case OpCode::asin:          *out = asin(a); break;
+            case OpCode::acos:          *out = acos(a); break;
+            case OpCode::atan:          *out = atan(a); break;
+            case OpCode::asinh:         *out = asinh(a); break;
+            case OpCode::acosh:         *out = acosh(a); break;
+            case OpCode::atanh:         *out = atanh(a); break;
+            case OpCode::abs:           *out = abs(a); break;
+            case OpCode::conj:          *out = conj(a); break;
+            case OpCode::real:          *out = real(a); break;
+            case OpCode::imag:          *out = imag(a); break;
+        }
+        ++out;
+    }
+    return registers[result_register];
+}
+
+#define COMPI_INSTANTIATE_EXPRESSION_REGISTER(Register) \
+    template void CompiledExpression::initialise_registers<Register>(const std::vector<Register>&, std::vector<Register>&) const; \
+    template Register CompiledExpression::evaluate<Register>(Real, std::vector<Register>&) const noexcept;
+
+COMPI_INSTANTIATE_EXPRESSION_REGISTER(complex<Real>)
+COMPI_INSTANTIATE_EXPRESSION_REGISTER(ExpressionDual<1>)
+COMPI_INSTANTIATE_EXPRESSION_REGISTER(ExpressionDual<2>)
+COMPI_INSTANTIATE_EXPRESSION_REGISTER(ExpressionDual<3>)
+COMPI_INSTANTIATE_EXPRESSION_REGISTER(ExpressionDual<4>)
+COMPI_INSTANTIATE_EXPRESSION_REGISTER(ExpressionDual<5>)
+COMPI_INSTANTIATE_EXPRESSION_REGISTER(ExpressionDual<6>)
+COMPI_INSTANTIATE_EXPRESSION_REGISTER(ExpressionDual<7>)
+COMPI_INSTANTIATE_EXPRESSION_REGISTER(ExpressionDual<8>)
+static_assert(max_gradient_parameters == 8, "An instantiation is needed for each number of gradient parameters");
+
+std::shared_ptr<const CompiledExpression> compile_expression(const std::string& source){
+    // Expressions are only dropped from the cache when it fills up, which should only
+    // happen if expressions are being generated programmatically. The least recently used
+    // expression is dropped, so those still in use keep their compiled form
+    constexpr size_t max_cached_expressions = 1024;
+    using Entry = std::pair<std::string,std::shared_ptr<const CompiledExpression>>;
+    static std::mutex cache_mutex;
+    // Most recently used first
+    static std::list<Entry> entries;
+    static std::unordered_map<std::string,std::list<Entry>::iterator> index;
+
+    std::lock_guard<std::mutex> lock{cache_mutex};
+
+    const auto cached = index.find(source);
+    if(cached != index.end()){
+        entries.splice(entries.begin(),entries,cached->second);
+        return cached->second->second;
+    }
+
+    auto compiled = std::make_shared<const CompiledExpression>(source);
+    entries.emplace_front(source,compiled);
+    index.emplace(source,entries.begin());
+    if(entries.size() > max_cached_expressions){
+        index.erase(entries.back().first);
+        entries.pop_back();
+    }
+    return compiled;
+}
+
+ExpressionIntegrand::ExpressionIntegrand(std::shared_ptr<const CompiledExpression> compiled, const std::unordered_map<std::string,complex<Real>>& parameter_values)
+    :expression{std::move(compiled)}, registers{}{
+    expression->initialise_registers(expression->bind_parameters(parameter_values),registers);
+}
+
+}
@@ -0,0 +1,153 @@
+#ifndef COMPI_EXPRESSION_GUARD
+#define COMPI_EXPRESSION_GUARD
+
+#include "compi.hpp"
+
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "compi_engines.hpp"
+
+namespace compi_internal {
+
+class invalid_expression: public std::invalid_argument{
+    using std::invalid_argument::invalid_argument;
+    public:
+        invalid_expression(const std::string& c_message, const char* python_message): std::invalid_argument(c_message){
+        PyErr_SetString(PyExc_ValueError,python_message);
+    }
+};
+
+// The most parameters an expression can be differentiated with respect to
+constexpr std::size_t max_gradient_parameters = 8;
+
+// Register type used to evaluate an expression along with its derivatives with respect to N
+// of its parameters
+template<std::size_t N>
+using ExpressionDual = compi::Dual<std::complex<Real>,N>;
+
+// An integrand given as a Python style expression in x, e.g. "exp(1j*w*x)/(x**2+a**2)",
+// compiled into a register based bytecode over complex numbers.
+//
+// Registers are laid out as
+//      x, then each named parameter, then each literal constant, then one register for
+//      the result of each instruction
+// so an expression is evaluated by filling in x and running the instructions in order,
+// with the result left in the last register.
+//
+// Registers are either complex numbers or, to evaluate derivatives with respect to the
+// parameters, ExpressionDual. The templates below are instantiated for std::complex<Real> and
+// ExpressionDual<N> for N up to max_gradient_parameters.
+//
+// A CompiledExpression is immutable once constructed, so may be shared between threads.
+// Parameter values are supplied separately, by binding it into an ExpressionIntegrand.
+class CompiledExpression{
+    public:
+        enum class OpCode: std::uint8_t {
+            add, subtract, multiply, divide, negate, power, integer_power,
+            exp, log, sqrt, sin, cos, tan, sinh, cosh, tanh,
+            asin, acos, atan, asinh, acosh, atanh, abs, conj, real, imag
+        };
+
+        struct Instruction{
+            OpCode op;
+            std::uint16_t a;
+            std::uint16_t b; // unused by unary operations. The (signed) exponent for integer_power
+        };
+
+        // Throws invalid_expression, setting a Python ValueError, if source is not a valid expression
+        explicit CompiledExpression(const std::string& source);
+
+        const std::vector<std::string>& parameter_names() const noexcept{
+            return parameters;
+        }
+
+        size_t register_count() const noexcept{
+            return 1 + parameters.size() + constants.size() + code.size();
+        }
+
+        // Returns the values in parameter_values of each of the parameters, in the order given
+        // by parameter_names(). Throws invalid_expression if a value is not given for every
+        // parameter, or a value is given for a name which is not a parameter
+        std::vector<std::complex<Real>> bind_parameters(const std::unordered_map<std::string,std::complex<Real>>& parameter_values) const;
+
+        // Returns the index of the parameter called name in parameter_names(). Throws
+        // invalid_expression if there is none
+        size_t parameter_index(const std::string& name) const;
+
+        // Fills in the registers for the parameters and constants.
+        // parameter_values must be in the order given by parameter_names()
+        template<typename Register>
+        void initialise_registers(const std::vector<Register>& parameter_values, std::vector<Register>& registers) const;
+
+        // registers must have been set up by initialise_registers
+        template<typename Register>
+        Register evaluate(Real x, std::vector<Register>& registers) const noexcept;
+
+    private:
+        std::vector<std::string> parameters;
+        std::vector<std::complex<Real>> constants;
+        std::vector<Instruction> code;
+        std::uint16_t result_register = 0;
+
+        friend class ExpressionParser;
+};
+
+// Returns the compiled form of source, which is only parsed the first time it is seen.
+// Safe to call from multiple threads.
+std::shared_ptr<const CompiledExpression> compile_expression(const std::string& source);
+
+// A CompiledExpression with values bound to each of its parameters, callable as an integrand.
+// Each ExpressionIntegrand keeps its own registers, so must only be used by one thread at a time
+class ExpressionIntegrand{
+    private:
+        std::shared_ptr<const CompiledExpression> expression;
+        mutable std::vector<std::complex<Real>> registers;
+
+    public:
+        // Throws invalid_expression if a value is not given for every parameter, or a value
+        // is given for a name which is not a parameter
+        ExpressionIntegrand(std::shared_ptr<const CompiledExpression> compiled, const std::unordered_map<std::string,std::complex<Real>>& parameter_values);
+
+        std::complex<Real> operator()(Real x) const noexcept{
+            return expression->evaluate(x,registers);
+        }
+};
+
+// A CompiledExpression with values bound to each of its parameters, which evaluates the
+// expression along with its derivatives with respect to N of them. As for ExpressionIntegrand,
+// must only be used by one thread at a time
+template<std::size_t N>
+class ExpressionGradientIntegrand{
+    private:
+        std::shared_ptr<const CompiledExpression> expression;
+        mutable std::vector<ExpressionDual<N>> registers;
+
+    public:
+        // Throws invalid_expression as ExpressionIntegrand, or if a name in wrt is not a
+        // parameter of the expression. wrt must have N elements
+        ExpressionGradientIntegrand(std::shared_ptr<const CompiledExpression> compiled, const std::unordered_map<std::string,std::complex<Real>>& parameter_values, const std::vector<std::string>& wrt)
+            :expression{std::move(compiled)}, registers{}{
+            const std::vector<std::complex<Real>> values = expression->bind_parameters(parameter_values);
+
+            std::vector<ExpressionDual<N>> parameters(values.cbegin(),values.cend());
+            for(size_t k = 0; k < N; ++k){
+                const size_t index = expression->parameter_index(wrt.at(k));
+                parameters[index] = ExpressionDual<N>::parameter(values[index],k);
+            }
+            expression->initialise_registers(parameters,registers);
+        }
+
+        ExpressionDual<N> operator()(Real x) const noexcept{
+            return expression->evaluate(x,registers);
+        }
+};
+
+}
+#endif
@@ -0,0 +1,192 @@
+#include "compi.hpp"
+
+#include <complex>
+#include <functional>
+#include <limits>
+#include <regex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/math/tools/precision.hpp>
+
+extern "C" {
+    #include "integration_routines.h"
+}
+
+#include "compi_engines.hpp"
+#include "expression.hpp"
+#include "IntegrandFunctionWrapper.hpp"
+#include "utils.hpp"
+
+namespace {
+
+using compi_internal::max_gradient_parameters;
+
+struct GradientParameters{
+    PyObject* integrand;
+    Real x_min;
+    Real x_max;
+    PyObject* kw;
+    PyObject* wrt = Py_None;
+
+    bool full_output = false;
+    unsigned max_levels = 15;
+    Real tolerance = boost::math::tools::root_epsilon<Real>();
+    Real atol = 0;
+
+    std::unordered_map<std::string,std::complex<Real>> parameter_values{};
+    std::vector<std::string> wrt_names{};
+};
+
+// Parses the arguments into parameters, returning false with a Python error set on failure
+bool parse_arguments(PyObject* args, PyObject* kwargs, GradientParameters& parameters){
+    static const char* keywords[] = {"f","a","b","kwargs","wrt","full_output","max_levels","tolerance","atol",nullptr};
+
+    if(!PyArg_ParseTupleAndKeywords(args,kwargs,"OddO|O$pIdd",const_cast<char**>(keywords),
+            &parameters.integrand,&parameters.x_min,&parameters.x_max,&parameters.kw,&parameters.wrt,
+            &parameters.full_output,&parameters.max_levels,&parameters.tolerance,&parameters.atol)){
+        return false;
+    }
+
+    if(!(parameters.atol >= 0)){
+        PyErr_SetString(PyExc_ValueError,"atol cannot be negative");
+        return false;
+    }
+    if(!PyUnicode_Check(parameters.integrand)){
+        PyErr_SetString(PyExc_ValueError,"integrate_with_grad requires f to be a str containing an expression");
+        return false;
+    }
+    if(!PyDict_Check(parameters.kw)){
+        PyErr_SetString(PyExc_ValueError,"The values of the parameters of the expression must be given as a dict");
+        return false;
+    }
+
+    try{
+        parameters.parameter_values = compi_internal::expression_parameter_values(parameters.kw);
+    } catch(const compi_internal::invalid_expression& e){
+        return false;
+    } catch(const compi_internal::PythonError& e){
+        return false;
+    }
+
+    // By default the derivatives are taken with respect to every parameter, in the order given
+    PyObject* wrt = parameters.wrt == Py_None ? PyDict_Keys(parameters.kw) : PySequence_Fast(parameters.wrt,"wrt must be a sequence of parameter names");
+    if(!wrt){
+        return false;
+    }
+    std::unique_ptr<PyObject,compi_internal::PyObjectDecRef> wrt_owner{wrt};
+
+    const Py_ssize_t wrt_count = PySequence_Fast_GET_SIZE(wrt);
+    for(Py_ssize_t i = 0; i < wrt_count; ++i){
+        PyObject* name = PySequence_Fast_GET_ITEM(wrt,i);
+        const char* c_name = PyUnicode_Check(name) ? PyUnicode_AsUTF8(name) : NULL;
+        if(!c_name){
+            PyErr_Clear();
+            PyErr_SetString(PyExc_ValueError,"The names in wrt must be str");
+            return false;
+        }
+        parameters.wrt_names.emplace_back(c_name);
+    }
+
+    if(parameters.wrt_names.empty() || parameters.wrt_names.size() > max_gradient_parameters){
+        PyErr_Format(PyExc_ValueError,"integrate_with_grad can differentiate with respect to between 1 and %zu parameters",max_gradient_parameters);
+        return false;
+    }
+    return true;
+}
+
+template<std::size_t N>
+using GradientResult = compi::GradientResult<std::complex<Real>,N>;
+
+// Integrates the expression, with the derivatives with respect to the N parameters in wrt,
+// and builds the Python result
+template<std::size_t N>
+PyObject* integrate_gradient(const GradientParameters& parameters){
+    using namespace compi_internal;
+
+    std::unique_ptr<ExpressionGradientIntegrand<N>> f;
+    try{
+        Py_ssize_t source_size;
+        const char* source = PyUnicode_AsUTF8AndSize(parameters.integrand,&source_size);
+        if(source == NULL){
+            return NULL;
+        }
+        f = std::make_unique<ExpressionGradientIntegrand<N>>(compile_expression(std::string(source,source_size)),parameters.parameter_values,parameters.wrt_names);
+    } catch(const invalid_expression& e){
+        return NULL;
+    }
+
+    GradientResult<N> result;
+    try{
+        // The expression never calls into Python, so is integrated without the GIL
+        ReleaseGIL release_gil{true};
+        result = compi::integrate_with_grad(std::cref(*f),parameters.x_min,parameters.x_max,compi::Options{parameters.max_levels,parameters.tolerance,parameters.atol});
+    } catch( const boost::wrapexcept<std::domain_error>& e){
+        if(std::regex_search(e.what(),std::basic_regex<char>("The function you are trying to integrate does not go to zero at infinity")) ){
+            PyErr_SetString(PyExc_ValueError, "Function to be integrated does not go to 0 at infinity");
+        }
+        else{
+            PyErr_SetString(PyExc_RuntimeError,e.what());
+        }
+        return NULL;
+    } catch(const std::invalid_argument& e){
+        PyErr_SetString(PyExc_ValueError, e.what());
+        return NULL;
+    } catch(const std::exception& e){
+        PyErr_SetString(PyExc_RuntimeError, e.what());
+        return NULL;
+    } catch(...){
+        PyErr_SetString(PyExc_RuntimeError, "An unknown error has occured");
+        return NULL;
+    }
+
+    PyObject* gradient = PyTuple_New(N);
+    if(!gradient){
+        return NULL;
+    }
+    for(size_t k = 0; k < N; ++k){
+        PyObject* derivative = PyComplex_FromDoubles(result.gradient[k].real(),result.gradient[k].imag());
+        if(!derivative){
+            Py_DECREF(gradient);
+            return NULL;
+        }
+        PyTuple_SET_ITEM(gradient,k,derivative);
+    }
+
+    auto c_complex_result = c_complex_from_complex(result.result);
+    if(parameters.full_output){
+        return Py_BuildValue("(DNd{sdsnsssOsz})",&c_complex_result,gradient,result.err,
+                             "L1 norm",result.l1,"levels",static_cast<Py_ssize_t>(result.levels),
+                             "method",result.method,"converged",result.converged ? Py_True : Py_False,
+                             "criterion",result.criterion);
+    }
+    return Py_BuildValue("(DNd)",&c_complex_result,gradient,result.err);
+}
+
+// The number of parameters is only known at runtime, so is matched to an instantiation
+template<std::size_t N = 1>
+PyObject* dispatch_integrate_gradient(const GradientParameters& parameters){
+    if constexpr(N > max_gradient_parameters){
+        PyErr_SetString(PyExc_ValueError,"Too many parameters to differentiate with respect to");
+        return NULL;
+    }
+    else{
+        if(parameters.wrt_names.size() == N){
+            return integrate_gradient<N>(parameters);
+        }
+        return dispatch_integrate_gradient<N+1>(parameters);
+    }
+}
+
+}
+
+// Integrates an expression from a to b along with its derivatives with respect to its
+// parameters, evaluating it with forward mode dual numbers in a single integration
+extern "C" PyObject* integrate_with_grad(PyObject* self, PyObject* args, PyObject* kwargs){
+    GradientParameters parameters;
+    if(!parse_arguments(args,kwargs,parameters)){
+        return NULL;
+    }
+    return dispatch_integrate_gradient(parameters);
+}
@@ -12,4 +12,8 @@ PyObject* sinh_sinh(PyObject* self, PyObject* args, PyObject* kwargs);
 PyObject* exp_sinh(PyObject* self, PyObject* args, PyObject* kwargs);
 
 PyObject* trapezoidal(PyObject* self, PyObject* args, PyObject* kwargs);
+
+PyObject* quad(PyObject* self, PyObject* args, PyObject* kwargs);
+
+PyObject* integrate_with_grad(PyObject* self, PyObject* args, PyObject* kwargs);
 #endif
@@ -4,14 +4,18 @@
 #include "compi.hpp"
 
 #include <array>
+#include <cmath>
 #include <complex>
+#include <limits>
 #include <utility>
 #include <stdexcept>
 #include <regex>
 
 #include <boost/math/tools/precision.hpp>
 
+#include "compi_engines.hpp"
 #include "IntegrandFunctionWrapper.hpp"
+#include "result_cache.hpp"
 #include "utils.hpp"
 
 enum class IntegralRange: short unsigned {infinite, semi_infinite, finite};
@@ -23,7 +27,7 @@ enum class IntegralRange: short unsigned {infinite, semi_infinite, finite};
 template<IntegralRange bounds,size_t L=0, size_t M=0, size_t N=0>
 constexpr auto generate_keyword_list(const std::array<const char*, L>& required = {}, const std::array<const char*,M> optional = {}, const std::array<const char*,N> keyword_only = {}) noexcept {
 
-    std::array<const char *, L+M+N+7+static_cast<size_t>(bounds)> keywords{"f"};
+    std::array<const char *, L+M+N+11+static_cast<size_t>(bounds)> keywords{"f"};
 
     size_t k_idx = 1;
 
@@ -49,6 +53,10 @@ constexpr auto generate_keyword_list(const std::array<const char*, L>& required
     keywords[k_idx++] = "full_output";
     keywords[k_idx++] = "max_levels";
     keywords[k_idx++] = "tolerance";
+    keywords[k_idx++] = "atol";
+    keywords[k_idx++] = "max_evaluations";
+    keywords[k_idx++] = "timeout";
+    keywords[k_idx++] = "cache_key";
 
     for(auto kw: keyword_only){
         keywords[k_idx++] = kw;
@@ -67,16 +75,32 @@ struct RoutineParametersBase{
     bool full_output = false;
     Real tolerance = boost::math::tools::root_epsilon<Real>();
     unsigned max_levels = 15;
+    // Absolute tolerance on the error. By default only the relative tolerance is used
+    Real atol = 0;
 
-    struct result_type{
-        std::complex<Real> result;
-        Real err;
-        Real l1;
-    };
+    // Budgets for the integration. By default there is no limit on either
+    Py_ssize_t max_evaluations = PY_SSIZE_T_MAX;
+    Real timeout = std::numeric_limits<Real>::infinity();
+
+    // Identifies the integrand in the result cache. If None, expressions are identified by their
+    // source, and callables are not cached
+    PyObject* cache_key = Py_None;
+
+    using result_type = compi::Result<std::complex<Real>>;
 
     RoutineParametersBase() = default;
     explicit RoutineParametersBase(Real tol, unsigned levels):tolerance{tol},max_levels{levels}{}
 
+    compi::Options options() const noexcept{
+        return compi::Options{max_levels,tolerance,atol};
+    }
+
+    // Returns a new reference to a tuple of the arguments particular to the routine, used to
+    // build its key in the result cache. Hidden by RoutineParameters with such arguments
+    PyObject* routine_arguments() const noexcept{
+        return PyTuple_New(0);
+    }
+
 };
 class could_not_parse_arguments: std::runtime_error{
     using std::runtime_error::runtime_error;
@@ -86,8 +110,57 @@ class unable_to_call_integration_routine: std::runtime_error{
     using std::runtime_error::runtime_error;
 };
 
+// Fills in the parts of a partial result which only some routines report, once the budget of f
+// has been exhausted. from_finished is true if the result is the estimate recorded in finished.
+// Overloaded for the RoutineParameters of those routines
+template<typename RoutineParameters, typename ResultType>
+void set_partial_result_details(ResultType&, bool, const compi::detail::FinishedEstimate<std::complex<Real>>&, const compi_internal::IntegrandFunctionWrapper&, const RoutineParameters&) noexcept{}
+
+// Called once the evaluation budget of f has been exhausted part way through an integration.
+// The double exponential routines, and quad once its probe is finished, record the estimate
+// from each level as it is finished (see compi::detail::finished_estimate), which is the best
+// result there is. The routines which do not are rerun with an increasing number of levels,
+// using only the evaluations already made, and the result from the most levels which could
+// be completed is returned. If not even the first level could be completed the result is NaN
+// with an infinite error
+template<typename RoutineParameters>
+auto rerun_with_previous_evaluations(compi_internal::IntegrandFunctionWrapper& f, const RoutineParameters& parameters){
+    // copied, as the reruns record their own estimates
+    const auto finished = compi::detail::finished_estimate<std::complex<Real>>();
+    f.replay_evaluations_only();
+
+    decltype(run_integration_routine(f,parameters)) result{};
+    result.result = std::complex<Real>(std::numeric_limits<Real>::quiet_NaN(),std::numeric_limits<Real>::quiet_NaN());
+    result.err = std::numeric_limits<Real>::infinity();
+    result.l1 = std::numeric_limits<Real>::quiet_NaN();
+
+    RoutineParameters reduced_parameters = parameters;
+    for(reduced_parameters.max_levels = 0; reduced_parameters.max_levels < parameters.max_levels; ++reduced_parameters.max_levels){
+        try{
+            // Only a finished attempt replaces the result, so running out of evaluations part way
+            // through a level leaves the previous level's result intact
+            auto attempt = run_integration_routine(f,reduced_parameters);
+            result = attempt;
+        } catch(const compi_internal::evaluation_budget_exhausted& e){
+            break;
+        }
+    }
+
+    const bool from_finished = finished.finished && (finished.levels > result.levels || !std::isfinite(result.err));
+    if(from_finished){
+        result = decltype(result){};
+        result.result = finished.result;
+        result.err = finished.err;
+        result.l1 = finished.l1;
+        result.levels = finished.levels;
+    }
+    set_partial_result_details(result,from_finished,finished,f,parameters);
+    return result;
+}
+
 // general template for running integration routines. handles the overall flow of control and exception handelling. Specialized based on 
-// RoutineParameters class, which stores the various parameters which the routine needs to run. Expects 3 funtions to exist.
+// RoutineParameters class, which stores the various parameters which the routine needs to run. Expects 3 funtions, and a static
+// name, used to identify the routine in the result cache, to exist.
 //      a construtor for RoutineParameters, which accepts the python arg tuple and keyword dict and handles parsing those into c type, stored
 //      in the constructed RoutineParameters instance. Throws could_not_parse_arguments exception on failure.
 //      run_integration_routine, which takes an IntegrandFunctionWrapper and a RoutineParameters instance and handles the actual calling of the integration routine
@@ -106,6 +179,19 @@ PyObject* integration_routine(PyObject* args, PyObject* kwargs){
         return NULL;
     }
 
+    if(!(parameters->atol >= 0)){
+        PyErr_SetString(PyExc_ValueError, "atol cannot be negative");
+        return NULL;
+    }
+    if(parameters->max_evaluations < 0){
+        PyErr_SetString(PyExc_ValueError, "max_evaluations cannot be negative");
+        return NULL;
+    }
+    if(!(parameters->timeout >= 0)){
+        PyErr_SetString(PyExc_ValueError, "timeout must be a non-negative number of seconds");
+        return NULL;
+    }
+
     // C++ wrapper for Python integrand funciton is constructed
     
     std::unique_ptr<IntegrandFunctionWrapper> f;
@@ -119,13 +205,59 @@ PyObject* integration_routine(PyObject* args, PyObject* kwargs){
         return NULL;
     } catch( const kwargs_given_not_dict& e){
         return NULL;
-    } 
+    } catch( const invalid_expression& e){
+        return NULL;
+    } catch( const PythonError& e){
+        return NULL;
+    }
+
+    // If the result cache is enabled and this exact call has been made before, the stored result
+    // is returned without integrating. Results limited by a timeout depend on more than the
+    // arguments, so are never cached
+    PyObject* cache_key = NULL;
+    if(parameters->timeout == std::numeric_limits<Real>::infinity() && ResultCache::instance().enabled()){
+        // The key is built from the parsed arguments, so that it does not depend on how they were passed
+        PyObject* routine_arguments = Py_BuildValue("(NiIddn)",parameters->routine_arguments(),
+                static_cast<int>(parameters->full_output),parameters->max_levels,parameters->tolerance,parameters->atol,parameters->max_evaluations);
+        if(!routine_arguments){
+            return NULL;
+        }
+        cache_key = cached_integration_key(RoutineParameters::name,parameters->integrand,parameters->cache_key,
+                                            parameters->args,parameters->kw,routine_arguments);
+        Py_DECREF(routine_arguments);
+        if(cache_key){
+            PyObject* cached_result = find_cached_integration(cache_key);
+            if(cached_result){
+                Py_DECREF(cache_key);
+                return cached_result;
+            }
+        }
+    }
+    // Owns cache_key from here, however the routine returns
+    std::unique_ptr<PyObject,PyObjectDecRef> cache_key_owner{cache_key};
+
+    if(parameters->max_evaluations != PY_SSIZE_T_MAX || parameters->timeout != std::numeric_limits<Real>::infinity()){
+        f->set_budget(static_cast<size_t>(parameters->max_evaluations),parameters->timeout);
+    }
 
     // The actual integration routine is run
 
     decltype(run_integration_routine(*f,*parameters)) result;
+    bool converged = false;
+    const char* criterion = nullptr;
     try{
-        result = run_integration_routine(*f,*parameters);
+        try{
+            // Expression integrands never call into Python, so the GIL is released while
+            // they are integrated. Any exception reacquires it before being handled. The routines
+            // pass f to the integrators by reference, as copying the wrapper changes Python reference counts
+            ReleaseGIL release_gil{!f->requiresGIL()};
+            compi::detail::finished_estimate<std::complex<Real>>() = compi::detail::FinishedEstimate<std::complex<Real>>{};
+            result = run_integration_routine(*f,*parameters);
+            converged = result.converged;
+            criterion = result.criterion;
+        } catch( const evaluation_budget_exhausted& e){
+            result = rerun_with_previous_evaluations(*f,*parameters);
+        }
     } catch (const unable_to_call_integration_routine& e){
         return NULL;
     } catch( const unable_to_construct_py_object& e ){
@@ -160,16 +292,34 @@ PyObject* integration_routine(PyObject* args, PyObject* kwargs){
 
     auto c_complex_result = c_complex_from_complex(result.result);
 
+    PyObject* py_result;
     if(parameters->full_output){
         PyObject* full_output_dict = generate_full_output_dict(result,*parameters);
         if(!full_output_dict){
             return NULL;
         }
-        return Py_BuildValue("(DdO)", &c_complex_result, result.err,full_output_dict);
+        if(PyDict_SetItemString(full_output_dict,"converged",converged ? Py_True : Py_False) < 0){
+            Py_DECREF(full_output_dict);
+            return NULL;
+        }
+        // The stopping criterion which was met, or None
+        PyObject* py_criterion = Py_BuildValue("z",criterion);
+        if(!py_criterion || PyDict_SetItemString(full_output_dict,"criterion",py_criterion) < 0){
+            Py_XDECREF(py_criterion);
+            Py_DECREF(full_output_dict);
+            return NULL;
+        }
+        Py_DECREF(py_criterion);
+        py_result = Py_BuildValue("(DdN)", &c_complex_result, result.err,full_output_dict);
     }
     else{
-        return Py_BuildValue("(Dd)", &c_complex_result,result.err);
+        py_result = Py_BuildValue("(Dd)", &c_complex_result,result.err);
+    }
+
+    if(py_result && cache_key){
+        store_cached_integration(cache_key,py_result);
     }
+    return py_result;
 
 }
 
@@ -177,6 +327,6 @@ PyObject* integration_routine(PyObject* args, PyObject* kwargs){
 // levels of adaptive quadrature
 template<typename ExpIntegratorParameterType,typename ExpIntegratorResultType>
 PyObject* generate_full_output_dict(const ExpIntegratorResultType& result,const ExpIntegratorParameterType& parameters) noexcept{
-    return Py_BuildValue("{sdsI}","L1 norm",result.l1,"levels",result.levels);
+    return Py_BuildValue("{sdsn}","L1 norm",result.l1,"levels",static_cast<Py_ssize_t>(result.levels));
 }
 #endif
@@ -0,0 +1,33 @@
+#include "compi.hpp"
+
+#include <filesystem>
+#include <memory>
+
+extern "C" {
+    #include "node_tables.h"
+}
+
+#include "compi_node_tables.hpp"
+#include "utils.hpp"
+
+// Memory maps the node tables generated at build time, which are installed next to the
+// extension module, so that every process importing compi shares a single copy. A missing or
+// invalid file is not an error, since the tables are then generated as they are needed.
+extern "C" void load_shared_node_tables(PyObject* module){
+    PyObject* filename = PyModule_GetFilenameObject(module);
+    if(!filename){
+        PyErr_Clear();
+        return;
+    }
+    std::unique_ptr<PyObject,compi_internal::PyObjectDecRef> filename_owner{filename};
+
+    PyObject* encoded = PyUnicode_EncodeFSDefault(filename);
+    if(!encoded){
+        PyErr_Clear();
+        return;
+    }
+    std::unique_ptr<PyObject,compi_internal::PyObjectDecRef> encoded_owner{encoded};
+
+    const auto path = std::filesystem::path(PyBytes_AS_STRING(encoded)).replace_filename(COMPI_NODE_TABLES_FILE);
+    compi::load_node_tables(path.c_str());
+}
@@ -0,0 +1,10 @@
+#ifndef COMPI_NODE_TABLES_FUNCTIONS_GUARD
+#define COMPI_NODE_TABLES_FUNCTIONS_GUARD
+
+#include "compi.hpp"
+
+/* The file of double exponential node tables, written next to the extension at build time */
+#define COMPI_NODE_TABLES_FILE "compi_node_tables.bin"
+
+void load_shared_node_tables(PyObject* module);
+#endif
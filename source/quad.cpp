@@ -0,0 +1,71 @@
+#include "compi.hpp"
+
+#include <cmath>
+#include <complex>
+#include <functional>
+
+#include "compi_engines.hpp"
+
+extern "C" {
+    #include "integration_routines.h"
+}
+
+#include "integration_routines_template.hpp"
+#include "IntegrandFunctionWrapper.hpp"
+
+struct QuadParameters: public RoutineParametersBase {
+    static constexpr const char* name = "quad";
+    Real x_min;
+    Real x_max;
+
+    QuadParameters(PyObject* routine_args, PyObject* routine_kwargs){
+        constexpr auto keywords = generate_keyword_list<IntegralRange::finite>();
+
+        if(!PyArg_ParseTupleAndKeywords(routine_args,routine_kwargs,"Odd|OO$pIddndO",const_cast<char**>(keywords.data()),
+                &integrand,&x_min,&x_max,
+                &args,&kw,
+                &full_output, &max_levels,&tolerance,&atol,&max_evaluations,&timeout,&cache_key)){
+            throw could_not_parse_arguments("Unable to parse python arguments to C variables");
+        }
+
+        if(std::isnan(x_min) || std::isnan(x_max)){
+            PyErr_SetString(PyExc_ValueError,"The limits of integration cannot be nan");
+            throw could_not_parse_arguments("The limits of integration cannot be nan");
+        }
+    }
+
+    PyObject* routine_arguments() const noexcept{
+        return Py_BuildValue("(dd)",x_min,x_max);
+    }
+
+    using result_type = compi::QuadResult<std::complex<Real>>;
+};
+
+// The choice of routine is described with compi::quad
+QuadParameters::result_type run_integration_routine(const compi_internal::IntegrandFunctionWrapper& f, const QuadParameters& parameters){
+    return compi::quad(std::cref(f),parameters.x_min,parameters.x_max,parameters.options());
+}
+
+// quad counts the evaluations made by its last attempt, which only replays earlier ones, so the
+// count is taken from f. The estimate recorded by quad is of the integral over the range in
+// increasing order, so it is negated for a reversed range
+void set_partial_result_details(QuadParameters::result_type& result, bool from_finished, const compi::detail::FinishedEstimate<std::complex<Real>>& finished, const compi_internal::IntegrandFunctionWrapper& f, const QuadParameters& parameters) noexcept{
+    if(from_finished){
+        result.method = finished.method;
+        if(parameters.x_min > parameters.x_max){
+            result.result = -result.result;
+        }
+    }
+    result.evaluations = f.evaluations();
+}
+
+template<>
+PyObject* generate_full_output_dict(const QuadParameters::result_type& result, const QuadParameters& parameters) noexcept{
+    return Py_BuildValue("{sdsssn}","L1 norm",result.l1,"method",result.method,"evaluations",static_cast<Py_ssize_t>(result.evaluations));
+}
+
+// Integrates a Python function returning a complex from a to b, choosing the
+// quadrature routine to use based on the range and the behaviour of the integrand
+extern "C" PyObject* quad(PyObject* self, PyObject* args, PyObject* kwargs){
+    return integration_routine<QuadParameters>(args,kwargs);
+}
@@ -0,0 +1,438 @@
+#include "compi.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <random>
+#include <string>
+#include <system_error>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #define COMPI_MMAP_AVAILABLE
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+#include "result_cache.hpp"
+#include "utils.hpp"
+
+extern "C" {
+    #include "result_cache.h"
+}
+
+namespace compi_internal {
+
+namespace {
+
+// Each file on disk holds
+//      the magic string, then the format version, the length of the key and the length of the
+//      value as 64 bit integers, then the key and the value
+// The full key is stored so that files whose names collide can be told apart.
+// file_format_version must be incremented whenever the layout of the keys or the stored
+// results changes, so that files written by other versions of compi are ignored, not misread
+constexpr char file_magic[8] = {'C','O','M','P','I','R','C','1'};
+constexpr std::uint64_t file_format_version = 2;
+constexpr size_t file_header_size = sizeof(file_magic) + 3*sizeof(std::uint64_t);
+constexpr const char* file_extension = ".compi";
+
+std::uint64_t fnv1a_hash(const std::string& data) noexcept{
+    std::uint64_t hash = 14695981039346656037ull;
+    for(unsigned char c: data){
+        hash ^= c;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+std::filesystem::path path_for_key(const std::string& directory, const std::string& key){
+    char name[17];
+    std::snprintf(name,sizeof(name),"%016llx",static_cast<unsigned long long>(fnv1a_hash(key)));
+    return std::filesystem::path(directory) / (std::string(name) + file_extension);
+}
+
+// Checks the contents of a cache file, returning the value if it is stored for key
+std::optional<std::string> parse_file(const char* data, size_t size, const std::string& key){
+    if(size < file_header_size || std::memcmp(data,file_magic,sizeof(file_magic)) != 0){
+        return std::nullopt;
+    }
+    std::uint64_t format_version, key_length, value_length;
+    std::memcpy(&format_version,data+sizeof(file_magic),sizeof(format_version));
+    std::memcpy(&key_length,data+sizeof(file_magic)+sizeof(format_version),sizeof(key_length));
+    std::memcpy(&value_length,data+sizeof(file_magic)+sizeof(format_version)+sizeof(key_length),sizeof(value_length));
+
+    if(format_version != file_format_version || key_length != key.size() || value_length > size - file_header_size - key_length){
+        return std::nullopt;
+    }
+    if(std::memcmp(data+file_header_size,key.data(),key_length) != 0){
+        return std::nullopt;
+    }
+    return std::string(data+file_header_size+key_length,value_length);
+}
+
+std::optional<std::string> read_from_disk(const std::string& directory, const std::string& key){
+    const auto path = path_for_key(directory,key);
+
+    #ifdef COMPI_MMAP_AVAILABLE
+        const int fd = open(path.c_str(),O_RDONLY);
+        if(fd < 0){
+            return std::nullopt;
+        }
+        struct stat file_status;
+        if(fstat(fd,&file_status) != 0 || file_status.st_size <= 0){
+            close(fd);
+            return std::nullopt;
+        }
+        const size_t size = static_cast<size_t>(file_status.st_size);
+        void* data = mmap(nullptr,size,PROT_READ,MAP_SHARED,fd,0);
+        close(fd);
+        if(data == MAP_FAILED){
+            return std::nullopt;
+        }
+        auto value = parse_file(static_cast<const char*>(data),size,key);
+        munmap(data,size);
+        return value;
+    #else
+        std::ifstream file(path,std::ios::binary);
+        if(!file){
+            return std::nullopt;
+        }
+        const std::string contents{std::istreambuf_iterator<char>(file),std::istreambuf_iterator<char>()};
+        return parse_file(contents.data(),contents.size(),key);
+    #endif
+}
+
+void write_to_disk(const std::string& directory, const std::string& key, const std::string& value){
+    // Temporary files are unique to both the process and the write
+    static const auto process_token = std::random_device{}();
+    static std::atomic<unsigned long> temporary_count{0};
+
+    const auto path = path_for_key(directory,key);
+    auto temporary_path = path;
+    temporary_path += ".tmp." + std::to_string(process_token)
+                            + "." + std::to_string(temporary_count++);
+
+    {
+        std::ofstream file(temporary_path,std::ios::binary | std::ios::trunc);
+        if(!file){
+            return;
+        }
+        const std::uint64_t key_length = key.size();
+        const std::uint64_t value_length = value.size();
+        file.write(file_magic,sizeof(file_magic));
+        file.write(reinterpret_cast<const char*>(&file_format_version),sizeof(file_format_version));
+        file.write(reinterpret_cast<const char*>(&key_length),sizeof(key_length));
+        file.write(reinterpret_cast<const char*>(&value_length),sizeof(value_length));
+        file.write(key.data(),key.size());
+        file.write(value.data(),value.size());
+        if(!file){
+            file.close();
+            std::error_code ignored;
+            std::filesystem::remove(temporary_path,ignored);
+            return;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporary_path,path,error);
+    if(error){
+        std::filesystem::remove(temporary_path,error);
+    }
+}
+
+}
+
+ResultCache& ResultCache::instance(){
+    static ResultCache cache;
+    return cache;
+}
+
+void ResultCache::configure(size_t new_max_entries, std::string new_directory){
+    std::lock_guard<std::mutex> lock{mutex};
+    max_entries = new_max_entries;
+    directory = std::move(new_directory);
+    evict_in_memory();
+}
+
+bool ResultCache::enabled() const{
+    std::lock_guard<std::mutex> lock{mutex};
+    return max_entries > 0 || !directory.empty();
+}
+
+std::optional<std::string> ResultCache::find(const std::string& key){
+    std::string disk_directory;
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        auto it = index.find(key);
+        if(it != index.end()){
+            entries.splice(entries.begin(),entries,it->second);
+            ++hits;
+            return it->second->second;
+        }
+        disk_directory = directory;
+    }
+
+    std::optional<std::string> value;
+    if(!disk_directory.empty()){
+        value = read_from_disk(disk_directory,key);
+    }
+
+    std::lock_guard<std::mutex> lock{mutex};
+    if(value){
+        ++hits;
+        insert_in_memory(key,*value);
+    }
+    else{
+        ++misses;
+    }
+    return value;
+}
+
+void ResultCache::insert(const std::string& key, const std::string& value){
+    std::string disk_directory;
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        insert_in_memory(key,value);
+        disk_directory = directory;
+    }
+    if(!disk_directory.empty()){
+        write_to_disk(disk_directory,key,value);
+    }
+}
+
+void ResultCache::clear(bool disk){
+    std::string disk_directory;
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        entries.clear();
+        index.clear();
+        hits = 0;
+        misses = 0;
+        disk_directory = directory;
+    }
+    if(disk && !disk_directory.empty()){
+        std::error_code error;
+        for(const auto& file: std::filesystem::directory_iterator(disk_directory,error)){
+            if(file.path().extension() == file_extension){
+                std::filesystem::remove(file.path(),error);
+            }
+        }
+    }
+}
+
+ResultCache::Statistics ResultCache::statistics() const{
+    std::lock_guard<std::mutex> lock{mutex};
+    return Statistics{hits,misses,entries.size(),max_entries,directory};
+}
+
+void ResultCache::insert_in_memory(const std::string& key, const std::string& value){
+    if(max_entries == 0){
+        return;
+    }
+    auto it = index.find(key);
+    if(it != index.end()){
+        it->second->second = value;
+        entries.splice(entries.begin(),entries,it->second);
+        return;
+    }
+    entries.emplace_front(key,value);
+    index.emplace(key,entries.begin());
+    evict_in_memory();
+}
+
+void ResultCache::evict_in_memory(){
+    while(entries.size() > max_entries){
+        index.erase(entries.back().first);
+        entries.pop_back();
+    }
+}
+
+namespace {
+
+PyObject* marshal_dumps(PyObject* obj){
+    PyObject* marshal = PyImport_ImportModule("marshal");
+    if(!marshal){
+        return NULL;
+    }
+    PyObject* dumped = PyObject_CallMethod(marshal,"dumps","(O)",obj);
+    Py_DECREF(marshal);
+    return dumped;
+}
+
+PyObject* marshal_loads(const std::string& data){
+    PyObject* marshal = PyImport_ImportModule("marshal");
+    if(!marshal){
+        return NULL;
+    }
+    PyObject* loaded = PyObject_CallMethod(marshal,"loads","y#",data.data(),static_cast<Py_ssize_t>(data.size()));
+    Py_DECREF(marshal);
+    return loaded;
+}
+
+// Returns a new reference to a marshallable object identifying integrand, or NULL if it
+// cannot be identified
+PyObject* integrand_identity(PyObject* integrand, PyObject* cache_key){
+    if(cache_key != Py_None){
+        return Py_BuildValue("(sO)","key",cache_key);
+    }
+    if(PyUnicode_Check(integrand)){
+        return Py_BuildValue("(sO)","expression",integrand);
+    }
+    // Nothing marshallable identifies the behaviour of a callable, which may depend on global
+    // variables or other state, so callables are only cached with a cache_key
+    return NULL;
+}
+
+// Returns a new reference to a list of the items of the keyword arguments of the integrand,
+// sorted by name, so that the order they were given in does not change the key
+PyObject* sorted_integrand_kwargs(PyObject* kwargs){
+    if(kwargs == Py_None){
+        return PyList_New(0);
+    }
+    PyObject* items = dict_items(kwargs);
+    if(!items){
+        return NULL;
+    }
+    if(PyList_Sort(items) < 0){
+        Py_DECREF(items);
+        return NULL;
+    }
+    return items;
+}
+
+}
+
+PyObject* cached_integration_key(const char* name, PyObject* integrand, PyObject* cache_key, PyObject* integrand_args, PyObject* integrand_kwargs, PyObject* routine_arguments){
+    PyObject* identity = integrand_identity(integrand,cache_key);
+    if(!identity){
+        PyErr_Clear();
+        return NULL;
+    }
+
+    // No arguments for the integrand may be given either as None or as empty containers
+    PyObject* args = integrand_args == Py_None ? PyTuple_New(0) : integrand_args;
+    if(args == integrand_args){
+        Py_INCREF(args);
+    }
+    PyObject* kwargs = sorted_integrand_kwargs(integrand_kwargs);
+
+    PyObject* key = NULL;
+    if(args && kwargs){
+        PyObject* key_tuple = Py_BuildValue("(sOOOO)",name,identity,args,kwargs,routine_arguments);
+        if(key_tuple){
+            key = marshal_dumps(key_tuple);
+            Py_DECREF(key_tuple);
+        }
+    }
+    Py_DECREF(identity);
+    Py_XDECREF(args);
+    Py_XDECREF(kwargs);
+
+    if(!key){
+        PyErr_Clear();
+    }
+    return key;
+}
+
+PyObject* find_cached_integration(PyObject* key){
+    std::optional<std::string> value = ResultCache::instance().find(std::string(PyBytes_AS_STRING(key),PyBytes_GET_SIZE(key)));
+    if(!value){
+        return NULL;
+    }
+    PyObject* result = marshal_loads(*value);
+    if(!result){
+        // A corrupted or incompatible entry is treated as missing
+        PyErr_Clear();
+    }
+    return result;
+}
+
+void store_cached_integration(PyObject* key, PyObject* result) noexcept{
+    PyObject* value = marshal_dumps(result);
+    if(!value){
+        PyErr_Clear();
+        return;
+    }
+    try{
+        ResultCache::instance().insert(std::string(PyBytes_AS_STRING(key),PyBytes_GET_SIZE(key)),
+                                       std::string(PyBytes_AS_STRING(value),PyBytes_GET_SIZE(value)));
+    } catch(const std::exception& e){
+        // The result is still returned, just not cached
+    }
+    Py_DECREF(value);
+}
+
+}
+
+extern "C" PyObject* configure_cache(PyObject* self, PyObject* args, PyObject* kwargs){
+    static const char* keywords[] = {"maxsize","path",NULL};
+    Py_ssize_t max_entries = 128;
+    PyObject* path = Py_None;
+
+    if(!PyArg_ParseTupleAndKeywords(args,kwargs,"|nO",const_cast<char**>(keywords),&max_entries,&path)){
+        return NULL;
+    }
+    if(max_entries < 0){
+        PyErr_SetString(PyExc_ValueError,"maxsize cannot be negative");
+        return NULL;
+    }
+
+    std::string directory;
+    if(path != Py_None){
+        PyObject* encoded_path;
+        if(!PyUnicode_FSConverter(path,&encoded_path)){
+            return NULL;
+        }
+        directory = PyBytes_AS_STRING(encoded_path);
+        Py_DECREF(encoded_path);
+
+        std::error_code error;
+        std::filesystem::create_directories(directory,error);
+        if(error || !std::filesystem::is_directory(directory)){
+            PyErr_Format(PyExc_OSError,"Unable to use %s as a cache directory",directory.c_str());
+            return NULL;
+        }
+    }
+
+    compi_internal::ResultCache::instance().configure(static_cast<size_t>(max_entries),std::move(directory));
+    Py_RETURN_NONE;
+}
+
+extern "C" PyObject* clear_cache(PyObject* self, PyObject* args, PyObject* kwargs){
+    static const char* keywords[] = {"disk",NULL};
+    int disk = false;
+
+    if(!PyArg_ParseTupleAndKeywords(args,kwargs,"|p",const_cast<char**>(keywords),&disk)){
+        return NULL;
+    }
+    compi_internal::ResultCache::instance().clear(disk);
+    Py_RETURN_NONE;
+}
+
+extern "C" PyObject* cache_info(PyObject* self, PyObject* Py_UNUSED(args)){
+    const auto statistics = compi_internal::ResultCache::instance().statistics();
+
+    PyObject* path;
+    if(statistics.directory.empty()){
+        path = Py_None;
+        Py_INCREF(path);
+    }
+    else{
+        path = PyUnicode_DecodeFSDefault(statistics.directory.c_str());
+        if(!path){
+            return NULL;
+        }
+    }
+    return Py_BuildValue("{snsnsnsnsN}",
+                         "hits",static_cast<Py_ssize_t>(statistics.hits),
+                         "misses",static_cast<Py_ssize_t>(statistics.misses),
+                         "size",static_cast<Py_ssize_t>(statistics.entries),
+                         "maxsize",static_cast<Py_ssize_t>(statistics.max_entries),
+                         "path",path);
+}
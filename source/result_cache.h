@@ -0,0 +1,11 @@
+#ifndef COMPI_RESULT_CACHE_FUNCTIONS_GUARD
+#define COMPI_RESULT_CACHE_FUNCTIONS_GUARD
+
+#include "compi.hpp"
+
+PyObject* configure_cache(PyObject* self, PyObject* args, PyObject* kwargs);
+
+PyObject* clear_cache(PyObject* self, PyObject* args, PyObject* kwargs);
+
+PyObject* cache_info(PyObject* self, PyObject* args);
+#endif
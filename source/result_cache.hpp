@@ -0,0 +1,92 @@
+#ifndef COMPI_RESULT_CACHE_GUARD
+#define COMPI_RESULT_CACHE_GUARD
+
+#include "compi.hpp"
+
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+namespace compi_internal {
+
+// Process-wide store of the results of previous integrations, so that repeated calls can
+// skip the integration entirely. Disabled until configured from Python with configure_cache.
+//
+// Keys and values are opaque byte strings (in practice marshalled Python objects, see
+// cached_integration_key). There are two tiers:
+//      an in memory LRU cache, holding up to max_entries results
+//      an optional directory on disk, holding one file per result. Files are written to a
+//      temporary name and renamed into place, so are never seen part written, and read by
+//      memory mapping them. Any number of processes may therefore share the directory.
+// A result found on disk is also added to the in memory tier.
+//
+// Safe to call from multiple threads (and interpreters), as no Python objects are stored.
+class ResultCache{
+    public:
+        struct Statistics{
+            size_t hits;
+            size_t misses;
+            size_t entries;
+            size_t max_entries;
+            std::string directory;
+        };
+
+        static ResultCache& instance();
+
+        // directory may be empty, for no on disk tier
+        void configure(size_t max_entries, std::string directory);
+
+        bool enabled() const;
+
+        std::optional<std::string> find(const std::string& key);
+
+        void insert(const std::string& key, const std::string& value);
+
+        // Empties the in memory tier, and optionally deletes all results stored on disk
+        void clear(bool disk);
+
+        Statistics statistics() const;
+
+    private:
+        using Entry = std::pair<std::string,std::string>;
+
+        mutable std::mutex mutex;
+        // Most recently used first
+        std::list<Entry> entries;
+        std::unordered_map<std::string,std::list<Entry>::iterator> index;
+        size_t max_entries = 0;
+        std::string directory;
+        size_t hits = 0;
+        size_t misses = 0;
+
+        ResultCache() = default;
+
+        // Must be called with mutex held
+        void insert_in_memory(const std::string& key, const std::string& value);
+        void evict_in_memory();
+};
+
+// Builds the cache key for a call to the routine called name, from its parsed arguments, so
+// that the same integration gives the same key however its arguments were passed. The
+// integrand is identified by cache_key if given, or otherwise by the source of an expression
+// integrand. integrand_args and integrand_kwargs are the extra arguments of the integrand (a
+// tuple and a dict, or None) and routine_arguments a tuple of all the other arguments which
+// determine the result.
+// Returns NULL, without an exception set, if the call cannot be cached, i.e. if an identity for
+// the integrand cannot be found or the arguments cannot be marshalled
+PyObject* cached_integration_key(const char* name, PyObject* integrand, PyObject* cache_key, PyObject* integrand_args, PyObject* integrand_kwargs, PyObject* routine_arguments);
+
+// Returns a new reference to the result stored for key, or NULL, without an exception set, if
+// there is none
+PyObject* find_cached_integration(PyObject* key);
+
+// Stores result for key. Any failure to do so is silently ignored, since the cache is only
+// an optimisation
+void store_cached_integration(PyObject* key, PyObject* result) noexcept;
+
+}
+#endif
@@ -1,9 +1,9 @@
 #include "compi.hpp"
 
 #include <complex>
+#include <functional>
 
-#include <boost/math/quadrature/tanh_sinh.hpp>
-
+#include "compi_engines.hpp"
 #include "integration_routines_template.hpp"
 #include "IntegrandFunctionWrapper.hpp"
 
@@ -12,32 +12,28 @@ extern "C" {
 }
 
 struct TanhSinhParameters: public RoutineParametersBase {
+    static constexpr const char* name = "tanh_sinh";
     Real x_min;
     Real x_max;
 
     TanhSinhParameters(PyObject* routine_args, PyObject* routine_kwargs){
         constexpr auto keywords = generate_keyword_list<IntegralRange::finite>();
 
-        if(!PyArg_ParseTupleAndKeywords(routine_args,routine_kwargs,"Odd|OO$pId",const_cast<char**>(keywords.data()),
+        if(!PyArg_ParseTupleAndKeywords(routine_args,routine_kwargs,"Odd|OO$pIddndO",const_cast<char**>(keywords.data()),
                 &integrand,&x_min,&x_max,
                 &args,&kw,
-                &full_output, &max_levels,&tolerance)){
+                &full_output, &max_levels,&tolerance,&atol,&max_evaluations,&timeout,&cache_key)){
             throw could_not_parse_arguments("Unable to parse python arguments to C variables");
         }
     }
 
-    struct result_type:public RoutineParametersBase::result_type {
-        size_t levels;
-    };
+    PyObject* routine_arguments() const noexcept{
+        return Py_BuildValue("(dd)",x_min,x_max);
+    }
 };
 
 TanhSinhParameters::result_type run_integration_routine(const compi_internal::IntegrandFunctionWrapper& f,const TanhSinhParameters& parameters){
-    auto integrator = boost::math::quadrature::tanh_sinh<Real>(static_cast<size_t>(parameters.max_levels));
-    TanhSinhParameters::result_type result;
-
-    result.result =  integrator.integrate(f,parameters.x_min,parameters.x_max,parameters.tolerance,&(result.err),&(result.l1),&(result.levels));
-
-    return result;
+    return compi::tanh_sinh(std::cref(f),parameters.x_min,parameters.x_max,parameters.options());
 }
 
 
@@ -1,8 +1,10 @@
 #include "compi.hpp"
 
+#include <complex>
+#include <functional>
 #include <limits>
 
-#include <boost/math/quadrature/trapezoidal.hpp>
+#include "compi_engines.hpp"
 
 extern "C" {
     #include "integration_routines.h"
@@ -11,27 +13,39 @@ extern "C" {
 #include "IntegrandFunctionWrapper.hpp"
 
 struct TrapezoidParamerters: public RoutineParametersBase {
+    static constexpr const char* name = "trapezoidal";
     Real x_min, x_max;
+    bool periodic = false;
+    bool romberg = false;
 
     TrapezoidParamerters(PyObject* routine_args, PyObject* routine_kwargs):RoutineParametersBase{std::numeric_limits<Real>::epsilon(),12}{
-        constexpr auto keywords = generate_keyword_list<IntegralRange::finite>();
+        constexpr std::array<const char*,0> dumby_arg = {};
+        constexpr std::array<const char*,2> keyword_only_args = {"periodic","romberg"};
+        constexpr auto keywords = generate_keyword_list<IntegralRange::finite>(dumby_arg,dumby_arg,keyword_only_args);
 
 
-        if(!PyArg_ParseTupleAndKeywords(routine_args,routine_kwargs,"Odd|OO$pId",const_cast<char**>(keywords.data()),
+        if(!PyArg_ParseTupleAndKeywords(routine_args,routine_kwargs,"Odd|OO$pIddndOpp",const_cast<char**>(keywords.data()),
                 &integrand,&x_min,&x_max,
                 &args,&kw,
-                &full_output, &max_levels,&tolerance)){
+                &full_output, &max_levels,&tolerance,&atol,&max_evaluations,&timeout,&cache_key,
+                &periodic,&romberg)){
             throw could_not_parse_arguments("Unable to parse python arguments to C variables");
         }
+
+        if(periodic && romberg){
+            PyErr_SetString(PyExc_ValueError, "periodic and romberg cannot both be used in the same integration");
+            throw could_not_parse_arguments("periodic and romberg cannot both be used in the same integration");
+        }
+    }
+
+    PyObject* routine_arguments() const noexcept{
+        return Py_BuildValue("(ddii)",x_min,x_max,static_cast<int>(periodic),static_cast<int>(romberg));
     }
 };
 
 TrapezoidParamerters::result_type run_integration_routine(const compi_internal::IntegrandFunctionWrapper& f, const TrapezoidParamerters& params){
-    TrapezoidParamerters::result_type result;
-
-    result.result = boost::math::quadrature::trapezoidal(f,params.x_min, params.x_max,params.tolerance,params.max_levels, &(result.err),&(result.l1));
-
-    return result;
+    return compi::trapezoidal(std::cref(f),params.x_min,params.x_max,
+                              compi::TrapezoidalOptions{params.max_levels,params.tolerance,params.periodic,params.romberg,params.atol});
 }
 
 template<>
@@ -41,4 +55,4 @@ PyObject* generate_full_output_dict(const TrapezoidParamerters::result_type& res
 
 extern "C" PyObject* trapezoidal(PyObject* self, PyObject* args, PyObject* kwargs){
     return integration_routine<TrapezoidParamerters>(args,kwargs);
-}
\ No newline at end of file
+}
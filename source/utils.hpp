@@ -14,6 +14,28 @@ inline Py_complex c_complex_from_complex(const std::complex<Real> c) noexcept{
     return Py_complex{c.real(),c.imag()};
 }
 
+// Releases the GIL for the lifetime of the object, if release is true
+class ReleaseGIL{
+    private:
+        PyThreadState* thread_state;
+    public:
+        explicit ReleaseGIL(bool release) noexcept:thread_state{release ? PyEval_SaveThread() : nullptr}{}
+        ReleaseGIL(const ReleaseGIL&) = delete;
+        ReleaseGIL& operator=(const ReleaseGIL&) = delete;
+        ~ReleaseGIL(){
+            if(thread_state){
+                PyEval_RestoreThread(thread_state);
+            }
+        }
+};
+
+// Deleter for std::unique_ptr, releasing a reference to a Python object. The GIL must be held
+struct PyObjectDecRef{
+    void operator()(PyObject* obj) const noexcept{
+        Py_XDECREF(obj);
+    }
+};
+
 inline bool has_callable_method(PyObject* obj, const char* name){
     return PyObject_HasAttrString(obj, name) && PyCallable_Check(PyObject_GetAttrString(obj,name));
 }
@@ -45,6 +67,33 @@ inline PyObject* copy_py_tuple(PyObject* tup) noexcept{
     return new_tup;
 }
 
+// Returns a new reference to a list of the (key, value) items of dict, or NULL with a Python
+// error set. On free-threaded builds of Python another thread could modify dict while
+// PyDict_Next iterates over it, so the items are taken in a critical section on dict, and can
+// then be used, calling back into Python if need be, with dict unlocked
+inline PyObject* dict_items(PyObject* dict) noexcept{
+    PyObject* items;
+    #if PY_VERSION_HEX >= 0x030D0000
+        Py_BEGIN_CRITICAL_SECTION(dict);
+    #endif
+    items = PyList_New(PyDict_GET_SIZE(dict));
+    PyObject *key, *value;
+    Py_ssize_t pos = 0;
+    Py_ssize_t i = 0;
+    while(items && PyDict_Next(dict,&pos,&key,&value)){
+        PyObject* item = PyTuple_Pack(2,key,value);
+        if(!item){
+            Py_CLEAR(items);
+            break;
+        }
+        PyList_SET_ITEM(items,i++,item);
+    }
+    #if PY_VERSION_HEX >= 0x030D0000
+        Py_END_CRITICAL_SECTION();
+    #endif
+    return items;
+}
+
 template<typename RandomAccessContainer> 
 PyObject* py_list_from_real_container(const RandomAccessContainer& arr) noexcept{
     using obj_vector = std::vector<PyObject*>;
@@ -0,0 +1,315 @@
+// Tests the C++ library in compi_engines.hpp, without Python.
+// Returns non-zero if any check fails
+//      test_engines [node tables file]
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <complex>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+
+#include "compi_engines.hpp"
+
+namespace {
+
+int failures = 0;
+
+void check(bool condition, const char* description){
+    if(!condition){
+        ++failures;
+        std::cerr << "FAILED: " << description << '\n';
+    }
+}
+
+template<typename T>
+bool close(T value, T expected, double tolerance = 1e-8){
+    return std::abs(value - expected) <= tolerance*std::max(1.0,std::abs(expected));
+}
+
+template<typename Call>
+bool throws_invalid_argument(Call call){
+    try{
+        call();
+    } catch(const std::invalid_argument&){
+        return true;
+    }
+    return false;
+}
+
+const double pi = std::acos(-1.0);
+const double infinity = std::numeric_limits<double>::infinity();
+
+void test_node_tables(const char* generated_path){
+    using compi::detail::NodeMethod;
+
+    // Only levels which have not been used yet are taken from a file, so this runs first
+    if(generated_path){
+        check(compi::load_node_tables(generated_path),"the node tables generated at build time load");
+    }
+
+    const auto path = (std::filesystem::temp_directory_path() / "compi_test_node_tables.bin").string();
+    check(compi::write_node_tables(path.c_str(),4) && compi::load_node_tables(path.c_str()),"node tables can be written and loaded");
+    // The loaded file stays mapped, so it must not be truncated. Unlinking it is safe
+    std::filesystem::remove(path);
+
+    const auto invalid_path = (std::filesystem::temp_directory_path() / "compi_test_invalid_node_tables.bin").string();
+    {
+        std::ofstream file(invalid_path,std::ios::binary | std::ios::trunc);
+        file << "not a table of nodes";
+    }
+    check(!compi::load_node_tables(invalid_path.c_str()),"invalid node table files are rejected");
+
+    // The last weight of the file is that of the last row of the last level
+    check(compi::write_node_tables(invalid_path.c_str(),4),"node tables can be written");
+    {
+        std::fstream file(invalid_path,std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(-static_cast<std::streamoff>(sizeof(double)),std::ios::end);
+        const double corrupted = 1.5;
+        file.write(reinterpret_cast<const char*>(&corrupted),sizeof(corrupted));
+    }
+    check(!compi::load_node_tables(invalid_path.c_str()),"node table files with a corrupted level are rejected");
+    std::filesystem::remove(invalid_path);
+    check(!compi::load_node_tables(invalid_path.c_str()),"missing node table files are rejected");
+
+    bool rows_match = true;
+    for(auto method: {NodeMethod::tanh_sinh,NodeMethod::exp_sinh,NodeMethod::sinh_sinh}){
+        for(std::size_t level = 0; level < compi::default_node_table_levels; ++level){
+            const auto row = compi::detail::node_row(method,level);
+            const auto expected = compi::detail::generate_node_row(method,level);
+            rows_match = rows_match && row.size == expected.abscissas.size() && row.first_complement == expected.first_complement
+                         && std::equal(row.abscissas,row.abscissas+row.size,expected.abscissas.begin())
+                         && std::equal(row.weights,row.weights+row.size,expected.weights.begin());
+        }
+    }
+    check(rows_match,"loaded node tables match the generated rows");
+}
+
+// The double exponential routines give the same results, after the same number of levels, as
+// the stock boost integrators, whether or not they use the shared node tables
+void test_stock_integrator_parity(){
+    namespace quadrature = boost::math::quadrature;
+    auto kink = [](double x){ return std::abs(x - 0.3); };
+    auto singular = [](double x){ return 1/std::sqrt(x); };
+    auto gaussian = [](double x){ return std::exp(-x*x); };
+    auto lorentzian = [](double x){ return 1/(1 + x*x); };
+    auto damped = [](double x){ return std::cos(5*x)*std::exp(-x); };
+
+    bool tanh_sinh_matches = true, sinh_sinh_matches = true, exp_sinh_matches = true;
+    for(unsigned max_levels: {0u,3u,5u,7u,8u,10u,15u,20u}){
+        for(double tolerance: {1e-6,1.5e-8,1e-14}){
+            const compi::Options options{max_levels,tolerance};
+            double err, l1;
+            std::size_t levels;
+            auto same = [&levels](const compi::Result<double>& result, double expected){
+                return result.levels == levels && close(result.result,expected,1e-13);
+            };
+            auto tanh_sinh_same = [&](auto f, double a, double b){
+                const double expected = quadrature::tanh_sinh<double>(max_levels).integrate(f,a,b,tolerance,&err,&l1,&levels);
+                return same(compi::tanh_sinh(f,a,b,options),expected);
+            };
+            auto sinh_sinh_same = [&](auto f){
+                const double expected = quadrature::sinh_sinh<double>(max_levels).integrate(f,tolerance,&err,&l1,&levels);
+                return same(compi::sinh_sinh(f,options),expected);
+            };
+
+            tanh_sinh_matches = tanh_sinh_matches && tanh_sinh_same(kink,0.0,1.0) && tanh_sinh_same(singular,0.0,1.0)
+                                && tanh_sinh_same(damped,1.0,infinity);
+            sinh_sinh_matches = sinh_sinh_matches && sinh_sinh_same(gaussian) && sinh_sinh_same(lorentzian);
+            const double expected = quadrature::exp_sinh<double>(max_levels).integrate(damped,tolerance,&err,&l1,&levels);
+            exp_sinh_matches = exp_sinh_matches && same(compi::exp_sinh(damped,0.0,infinity,options),expected);
+        }
+    }
+    check(tanh_sinh_matches,"tanh_sinh matches boost::math::quadrature::tanh_sinh");
+    check(sinh_sinh_matches,"sinh_sinh matches boost::math::quadrature::sinh_sinh");
+    check(exp_sinh_matches,"exp_sinh matches boost::math::quadrature::exp_sinh");
+}
+
+void test_finite_routines(){
+    auto f = [](double x){ return std::complex<double>(0.0,3*x*x); };
+    const std::complex<double> expected(0.0,1.0);
+
+    check(close(compi::trapezoidal(f,0.0,1.0).result,expected,1e-6),"trapezoidal integrates 3i*x^2");
+    check(close(compi::gauss_kronrod(f,0.0,1.0).result,expected),"gauss_kronrod integrates 3i*x^2");
+    check(close(compi::tanh_sinh(f,0.0,1.0).result,expected),"tanh_sinh integrates 3i*x^2");
+    check(compi::tanh_sinh(f,0.0,1.0).converged,"tanh_sinh converges");
+    check(compi::tanh_sinh(f,0.0,1.0).levels > 0,"tanh_sinh reports its levels");
+
+    for(unsigned points: {15u,31u,41u,51u,61u}){
+        check(close(compi::gauss_kronrod(f,0.0,1.0,{15,1e-10,points}).result,expected),"gauss_kronrod integrates with every number of points");
+    }
+}
+
+void test_real_integrands(){
+    auto f = [](double x){ return std::cos(x); };
+    const compi::Result<double> result = compi::tanh_sinh(f,0.0,pi/2);
+    check(close(result.result,1.0),"real valued integrands give real results");
+}
+
+void test_trapezoidal_modes(){
+    auto periodic = [](double x){ return std::exp(std::cos(x)); };
+    const double expected = 2*pi*std::cyl_bessel_i(0.0,1.0);
+    check(close(compi::trapezoidal(periodic,0.0,2*pi,{12,1e-12,true,false}).result,expected,1e-12),"periodic trapezoidal");
+
+    auto smooth = [](double x){ return std::exp(x); };
+    const auto romberg = compi::trapezoidal(smooth,0.0,1.0,{12,1e-12,false,true});
+    check(close(romberg.result,std::exp(1.0)-1,1e-12),"romberg trapezoidal");
+    check(romberg.converged,"romberg trapezoidal converges");
+}
+
+void test_infinite_routines(){
+    auto gaussian = [](double x){ return std::exp(-x*x); };
+    check(close(compi::sinh_sinh(gaussian).result,std::sqrt(pi)),"sinh_sinh integrates a gaussian");
+
+    auto decaying = [](double x){ return std::exp(-std::abs(x-1)); };
+    check(close(compi::exp_sinh(decaying,1.0,infinity).result,1.0),"exp_sinh over the positive axis");
+    check(close(compi::exp_sinh(decaying,-infinity,1.0).result,1.0),"exp_sinh over the negative axis");
+}
+
+void test_quad(){
+    auto polynomial = [](double x){ return x*x; };
+    const auto smooth = compi::quad(polynomial,0.0,3.0);
+    check(close(smooth.result,9.0),"quad integrates x^2");
+    check(std::strcmp(smooth.method,"gauss_kronrod") == 0,"quad uses gauss_kronrod for smooth integrands");
+    check(smooth.evaluations > 0,"quad counts evaluations");
+
+    auto singular = [](double x){ return 1/std::sqrt(x); };
+    const auto endpoint = compi::quad(singular,0.0,1.0);
+    check(close(endpoint.result,2.0),"quad integrates 1/sqrt(x)");
+    check(std::strcmp(endpoint.method,"tanh_sinh") == 0,"quad uses tanh_sinh for endpoint singularities");
+
+    check(close(compi::quad(polynomial,3.0,0.0).result,-9.0),"quad negates reversed ranges");
+    auto gaussian = [](double x){ return std::exp(-x*x); };
+    check(std::strcmp(compi::quad(gaussian,-infinity,infinity).method,"sinh_sinh") == 0,"quad uses sinh_sinh for infinite ranges");
+    check(std::strcmp(compi::quad(gaussian,0.0,infinity).method,"exp_sinh") == 0,"quad uses exp_sinh for semi-infinite ranges");
+}
+
+void test_absolute_tolerance(){
+    int evaluations = 0;
+    auto root = [&evaluations](double x){
+        ++evaluations;
+        return std::sqrt(x);
+    };
+
+    // The singularity in the derivative at 0 stops 15 point Gauss-Kronrod reaching a relative tolerance of 1e-14
+    const auto relative = compi::gauss_kronrod(std::ref(root),0.0,1.0,{15,1e-14,15});
+    const int relative_evaluations = evaluations;
+    evaluations = 0;
+    const auto absolute = compi::gauss_kronrod(std::ref(root),0.0,1.0,{15,1e-14,15,1e-4});
+    check(!relative.converged && relative.criterion == nullptr,"gauss_kronrod does not reach the relative tolerance");
+    check(absolute.converged && std::strcmp(absolute.criterion,"absolute") == 0,"gauss_kronrod stops on the absolute tolerance");
+    check(absolute.err <= 1e-4 && close(absolute.result,2.0/3,1e-4),"gauss_kronrod with an absolute tolerance");
+    check(evaluations < relative_evaluations,"an absolute tolerance saves evaluations");
+
+    auto kink = [](double x){ return std::abs(x - 0.3); };
+    const auto tanh_sinh = compi::tanh_sinh(kink,0.0,1.0,{15,1e-14,1e-2});
+    check(std::strcmp(tanh_sinh.criterion,"absolute") == 0 && tanh_sinh.err <= 1e-2,"tanh_sinh stops on the absolute tolerance");
+    check(close(tanh_sinh.result,0.29,1e-2),"tanh_sinh with an absolute tolerance");
+
+    auto smooth = [](double x){ return std::exp(x); };
+    const auto trapezoidal = compi::trapezoidal(smooth,0.0,1.0,{12,1e-14,false,false,1e-4});
+    check(std::strcmp(trapezoidal.criterion,"absolute") == 0 && close(trapezoidal.result,std::exp(1.0)-1,1e-4),"trapezoidal stops on the absolute tolerance");
+
+    auto lorentzian = [](double x){ return 1/(1 + x*x); };
+    check(close(compi::gauss_kronrod(lorentzian,-infinity,infinity,{15,1e-14,15,1e-5}).result,pi,1e-5),"gauss_kronrod over an infinite range with an absolute tolerance");
+    check(close(compi::gauss_kronrod(lorentzian,1.0,infinity,{15,1e-14,15,1e-5}).result,pi/4,1e-5),"gauss_kronrod over a semi-infinite range with an absolute tolerance");
+
+    auto polynomial = [](double x){ return std::complex<double>(0.0,3*x*x); };
+    check(std::strcmp(compi::tanh_sinh(polynomial,0.0,1.0).criterion,"relative") == 0,"the relative criterion is reported first");
+}
+
+void test_dual_arithmetic(){
+    using D = compi::Dual<std::complex<double>,2>;
+    const D a = D::parameter(std::complex<double>(0.5,0.0),0);
+    const D b = D::parameter(std::complex<double>(2.0,0.0),1);
+
+    // d/da and d/db of a**b * exp(1j*a) / sqrt(b)
+    const D f = pow(a,b)*exp(std::complex<double>(0,1)*a)/sqrt(b);
+    const std::complex<double> value = std::pow(0.5,2.0)*std::exp(std::complex<double>(0,0.5))/std::sqrt(2.0);
+    check(close(f.value,value),"dual value");
+    check(close(f.gradient[0],value*(2.0/0.5 + std::complex<double>(0,1))),"dual derivative with respect to a");
+    check(close(f.gradient[1],value*(std::log(0.5) - 0.5/2.0)),"dual derivative with respect to b");
+
+    const auto magnitude = abs(D::parameter(std::complex<double>(3.0,4.0),0));
+    check(close(magnitude.value,5.0) && close(magnitude.gradient[0],0.6),"dual abs");
+}
+
+void test_integrate_with_grad(){
+    // The integral of exp(-a*x^2) over the real line is sqrt(pi/a)
+    const auto gaussian = compi::integrate_with_grad([](double x, const auto& p){ return exp(-p[0]*x*x); },
+                                                     -infinity,infinity,std::array<double,1>{2.0});
+    check(close(gaussian.result,std::sqrt(pi/2)),"integrate_with_grad value");
+    check(close(gaussian.gradient[0],-0.5*std::sqrt(pi)*std::pow(2.0,-1.5)),"integrate_with_grad derivative");
+    check(gaussian.converged,"integrate_with_grad converges");
+    check(std::strcmp(gaussian.method,"sinh_sinh") == 0,"integrate_with_grad uses sinh_sinh for infinite ranges");
+
+    // The integral of exp(i*w*x - b*x) from 0 to infinity is 1/(b - i*w)
+    using C = std::complex<double>;
+    const auto laplace = compi::integrate_with_grad([](double x, const auto& p){ return exp(C(0,1)*p[0]*x - p[1]*x); },
+                                                    0.0,infinity,std::array<C,2>{C(1.0),C(2.0)});
+    const C expected = 1.0/C(2.0,-1.0);
+    check(close(laplace.result,expected),"integrate_with_grad over a semi-infinite range");
+    check(close(laplace.gradient[0],C(0,1)*expected*expected),"integrate_with_grad derivative with respect to w");
+    check(close(laplace.gradient[1],-expected*expected),"integrate_with_grad derivative with respect to b");
+
+    const auto reversed = compi::integrate_with_grad([](double x, const auto& p){ return p[0]*x; },1.0,0.0,std::array<double,1>{3.0});
+    check(close(reversed.result,-1.5) && close(reversed.gradient[0],-0.5),"integrate_with_grad negates reversed ranges");
+}
+
+void test_integrand_passed_by_reference(){
+    int evaluations = 0;
+    auto counted = [&evaluations](double x){
+        ++evaluations;
+        return x;
+    };
+    compi::gauss_kronrod(std::ref(counted),0.0,1.0);
+    check(evaluations > 0,"integrands wrapped in std::ref are not copied");
+}
+
+void test_invalid_arguments(){
+    auto f = [](double x){ return x; };
+    check(throws_invalid_argument([&]{ compi::gauss_kronrod(f,0.0,1.0,{15,1e-8,17}); }),"invalid number of points");
+    check(throws_invalid_argument([&]{ compi::trapezoidal(f,0.0,1.0,{12,1e-8,true,true}); }),"periodic and romberg together");
+    check(throws_invalid_argument([&]{ compi::exp_sinh(f,0.0,1.0); }),"exp_sinh over a finite range");
+    check(throws_invalid_argument([&]{ compi::quad(f,std::nan(""),1.0); }),"quad with a nan limit");
+}
+
+void test_integrand_exceptions_propagate(){
+    auto f = [](double) -> double { throw std::runtime_error("integrand"); };
+    bool propagated = false;
+    try{
+        compi::tanh_sinh(f,0.0,1.0);
+    } catch(const std::runtime_error& e){
+        propagated = std::strcmp(e.what(),"integrand") == 0;
+    }
+    check(propagated,"exceptions thrown by the integrand propagate");
+}
+
+}
+
+int main(int argc, char** argv){
+    test_node_tables(argc > 1 ? argv[1] : nullptr);
+    test_stock_integrator_parity();
+    test_finite_routines();
+    test_real_integrands();
+    test_trapezoidal_modes();
+    test_infinite_routines();
+    test_quad();
+    test_absolute_tolerance();
+    test_dual_arithmetic();
+    test_integrate_with_grad();
+    test_integrand_passed_by_reference();
+    test_invalid_arguments();
+    test_integrand_exceptions_propagate();
+
+    if(failures){
+        std::cerr << failures << " check(s) failed\n";
+        return 1;
+    }
+    std::cout << "All checks passed\n";
+    return 0;
+}
@@ -232,6 +232,22 @@ class ExtraKwargTests(IntegrationRoutineTestsBase):
 
         self.assertEqual(kw_dict,initial_kw_dict)
 
+    def test_kwarg_dict_modified_by_integrand_not_used(self):
+        '''
+        The keyword arguments are fixed when the routine is called, so changes to the
+        dict passed (e.g. from another thread) do not change the integrand part way through
+        '''
+        kw_dict = {'kw':1j}
+        def test_func(x,kw):
+            kw_dict['kw'] = 2j
+            return complex(kw) *(1.0/(1+abs(0.1*x)))**2
+
+        result1,*_ = self.routine_to_test(test_func,*self.default_range,(),{'kw':1j})
+        kw_dict['kw'] = 1j
+        result2,*_ = self.routine_to_test(test_func,*self.default_range,(),kw_dict)
+
+        self.assertEqual(result1,result2)
+
     def test_kwarg_dict_reference_count_unchenged(self):
         def test_func(x,kw=3):
             return 1j * (x-5j)**-2
@@ -333,12 +349,169 @@ class IntegrationRoutineKeywordTests(IntegrationRoutineTestsBase):
         self.assertIsInstance(result[1],float)
         self.assertIsInstance(result[2],dict)
 
+    def test_full_output_contains_converged(self):
+        _,_,diagnostics = self.routine_to_test(self.func,*self.default_range, full_output=True)
+        self.assertIsInstance(diagnostics["converged"],bool)
+
+    def test_full_output_contains_criterion(self):
+        _,err,diagnostics = self.routine_to_test(self.func,*self.default_range, full_output=True)
+        self.assertIn(diagnostics["criterion"],("relative","L1 norm"))
+        self.assertTrue(diagnostics["converged"])
+
+    def test_accept_atol_keyword(self):
+        self._accept_ketword_test('atol', 1e-6)
+
+    def test_ValueError_for_negative_atol(self):
+        self.assertRaises(ValueError,self.routine_to_test,self.func,*self.default_range,atol=-1.0)
+        self.assertRaises(ValueError,self.routine_to_test,self.func,*self.default_range,atol=math.nan)
+
+    def test_atol_stops_refinement(self):
+        '''
+        Checks that an integration which cannot reach its relative tolerance stops once
+        the error is below atol, using no more evaluations and reporting the criterion met
+        '''
+        evaluations = 0
+        def difficult_function(x):
+            nonlocal evaluations
+            evaluations += 1
+            return cmath.exp(-0.25*abs(x)+ 1j*x)*abs(x-0.3)**0.5
+
+        _,_,diagnostics = self.routine_to_test(difficult_function,*self.default_range,tolerance=1e-15,full_output=True)
+        relative_evaluations = evaluations
+        self.assertIsNone(diagnostics["criterion"])
+
+        evaluations = 0
+        _,err,diagnostics = self.routine_to_test(difficult_function,*self.default_range,tolerance=1e-15,atol=1e-3,full_output=True)
+
+        self.assertTrue(diagnostics["converged"])
+        self.assertEqual("absolute",diagnostics["criterion"])
+        self.assertLessEqual(err,1e-3)
+        self.assertLessEqual(evaluations,relative_evaluations)
+
+    def test_accept_max_evaluations_keyword(self):
+        self._accept_ketword_test('max_evaluations', 10**6)
+
+    def test_accept_timeout_keyword(self):
+        self._accept_ketword_test('timeout', 10.0)
+
+    def test_ValueError_for_negative_budgets(self):
+        self.assertRaises(ValueError,self.routine_to_test,self.func,*self.default_range,max_evaluations=-1)
+        self.assertRaises(ValueError,self.routine_to_test,self.func,*self.default_range,timeout=-1.0)
+
+    def test_generous_budget_does_not_change_result(self):
+        result,err = self.routine_to_test(self.func,*self.default_range)
+        budget_result,budget_err = self.routine_to_test(self.func,*self.default_range,max_evaluations=10**7,timeout=100.0)
+
+        self.assertEqual(result,budget_result)
+        self.assertEqual(err,budget_err)
+
+    def test_max_evaluations_gives_partial_result(self):
+        '''
+        Checks that an integration which runs out of evaluations stops within
+        its budget and returns the best result so far, marked as not converged
+        '''
+        evaluations = 0
+        def difficult_function(x):
+            nonlocal evaluations
+            evaluations += 1
+            return cmath.exp(-0.25*abs(x)+ 1j*x)/(0.501-x)
+
+        _ = self.routine_to_test(difficult_function,*self.default_range)
+        max_evaluations = evaluations//2
+
+        evaluations = 0
+        result,err,diagnostics = self.routine_to_test(difficult_function,*self.default_range,max_evaluations=max_evaluations,full_output=True)
+
+        self.assertLessEqual(evaluations,max_evaluations)
+        self.assertTrue(cmath.isfinite(result))
+        self.assertTrue(math.isfinite(err))
+        self.assertFalse(diagnostics["converged"])
+
+    def test_max_evaluations_one_short_gives_partial_result(self):
+        '''
+        Checks that an integration which runs out of evaluations part way through its
+        last level returns the level before it, rather than nan
+        '''
+        evaluations = 0
+        def difficult_function(x):
+            nonlocal evaluations
+            evaluations += 1
+            return cmath.exp(-0.25*abs(x)+ 1j*x)/(0.501-x)
+
+        _ = self.routine_to_test(difficult_function,*self.default_range)
+        max_evaluations = evaluations - 1
+
+        evaluations = 0
+        result,err,diagnostics = self.routine_to_test(difficult_function,*self.default_range,max_evaluations=max_evaluations,full_output=True)
+
+        self.assertLessEqual(evaluations,max_evaluations)
+        self.assertTrue(cmath.isfinite(result))
+        self.assertTrue(math.isfinite(err))
+        self.assertFalse(diagnostics["converged"])
+
+    def test_exhausted_budget_returns_nan(self):
+        def test_function(x):
+            raise AssertionError("Integrand should not be evaluated")
+
+        for budget in ({"max_evaluations":0},{"timeout":0.0}):
+            result,err,diagnostics = self.routine_to_test(test_function,*self.default_range,full_output=True,**budget)
+
+            self.assertTrue(cmath.isnan(result))
+            self.assertEqual(math.inf,err)
+            self.assertFalse(diagnostics["converged"])
+
+class ExpressionIntegrandTests(IntegrationRoutineTestsBase):
+
+    def test_expression_matches_function(self):
+        expression_result,_ = self.routine_to_test("(1+2j)/(1+x**2)",*self.default_range)
+        function_result,_ = self.routine_to_test(lambda x: (1+2j)/(1+x*x),*self.default_range)
+
+        self.assertAlmostEqual(function_result,expression_result,places=12)
+
+    def test_expression_parameters_from_kwargs(self):
+        expression_result,_ = self.routine_to_test("a/(b+x**2)",*self.default_range,None,{'a':1j,'b':2})
+        function_result,_ = self.routine_to_test(lambda x,a,b: a/(b+x*x),*self.default_range,None,{'a':1j,'b':2})
+
+        self.assertAlmostEqual(function_result,expression_result,places=12)
+
+    def test_expression_parameters_change_result(self):
+        result1,_ = self.routine_to_test("a/(1+x**2)",*self.default_range,None,{'a':1j})
+        result2,_ = self.routine_to_test("a/(1+x**2)",*self.default_range,None,{'a':2j})
+
+        self.assertAlmostEqual(2*result1,result2,places=12)
+
+    def test_ValueError_for_invalid_expression(self):
+        for expression in ("1/(1+x**2","1/(1+x**)","1/$","unknown_function(x)",""):
+            self.assertRaises(ValueError,self.routine_to_test,expression,*self.default_range)
+
+    def test_ValueError_for_missing_expression_parameter(self):
+        self.assertRaises(ValueError,self.routine_to_test,"a/(1+x**2)",*self.default_range)
+
+    def test_ValueError_for_unknown_expression_parameter(self):
+        self.assertRaises(ValueError,self.routine_to_test,"a/(1+x**2)",*self.default_range,None,{'a':1,'b':2})
+
+    def test_ValueError_for_expression_with_positional_args(self):
+        self.assertRaises(ValueError,self.routine_to_test,"a/(1+x**2)",*self.default_range,(1,),{'a':1})
+
+    def test_expression_reference_count_does_not_change(self):
+        expression = "".join(("1/","(1+x**2)")) # constructed at run time, so not shared with other constants
+        initial_ref_count = sys.getrefcount(expression)
+        _ = self.routine_to_test(expression,*self.default_range)
+        self.assertEqual(initial_ref_count,sys.getrefcount(expression))
+
+    def test_expression_budget(self):
+        result,err,diagnostics = self.routine_to_test("1/(1+x**2)",*self.default_range,max_evaluations=0,full_output=True)
+
+        self.assertTrue(cmath.isnan(result))
+        self.assertFalse(diagnostics["converged"])
+
 class TestIntegrationRoutine(BasicFunctionalityTests,
                              ReferenceCountingTests,
                              ErrorRaisingTests,
                              ExtraArgTests,
                              ExtraKwargTests,
-                             IntegrationRoutineKeywordTests):
+                             IntegrationRoutineKeywordTests,
+                             ExpressionIntegrandTests):
     '''
     Tests functionality common to all integration routines 
     '''
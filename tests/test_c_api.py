@@ -0,0 +1,213 @@
+'''
+Tests the C API exported in compi._C_API, calling it through ctypes with the integrands
+written as ctypes callbacks
+'''
+import cmath
+import ctypes
+import math
+import unittest
+
+import compi
+
+class Complex(ctypes.Structure):
+    _fields_ = [("real", ctypes.c_double), ("imag", ctypes.c_double)]
+
+class Options(ctypes.Structure):
+    _fields_ = [("size", ctypes.c_size_t), ("max_levels", ctypes.c_uint), ("tolerance", ctypes.c_double), ("atol", ctypes.c_double)]
+
+    def __init__(self, max_levels=15, tolerance=2.0**-26, atol=0.0):
+        super().__init__(ctypes.sizeof(Options), max_levels, tolerance, atol)
+
+class Result(ctypes.Structure):
+    _fields_ = [("result", Complex),
+                ("error", ctypes.c_double),
+                ("l1", ctypes.c_double),
+                ("levels", ctypes.c_size_t),
+                ("converged", ctypes.c_int)]
+
+Integrand = ctypes.CFUNCTYPE(ctypes.c_int, ctypes.c_double, ctypes.c_void_p, ctypes.POINTER(Complex))
+
+OptionsP = ctypes.POINTER(Options)
+ResultP = ctypes.POINTER(Result)
+
+class API(ctypes.Structure):
+    _fields_ = [("version", ctypes.c_uint),
+                ("default_options", ctypes.CFUNCTYPE(ctypes.c_int, ctypes.c_int, OptionsP)),
+                ("status_message", ctypes.CFUNCTYPE(ctypes.c_char_p, ctypes.c_int)),
+                ("trapezoidal", ctypes.CFUNCTYPE(ctypes.c_int, Integrand, ctypes.c_void_p, ctypes.c_double, ctypes.c_double, OptionsP, ResultP)),
+                ("gauss_kronrod", ctypes.CFUNCTYPE(ctypes.c_int, Integrand, ctypes.c_void_p, ctypes.c_double, ctypes.c_double, ctypes.c_uint, OptionsP, ResultP)),
+                ("tanh_sinh", ctypes.CFUNCTYPE(ctypes.c_int, Integrand, ctypes.c_void_p, ctypes.c_double, ctypes.c_double, OptionsP, ResultP)),
+                ("sinh_sinh", ctypes.CFUNCTYPE(ctypes.c_int, Integrand, ctypes.c_void_p, OptionsP, ResultP)),
+                ("exp_sinh", ctypes.CFUNCTYPE(ctypes.c_int, Integrand, ctypes.c_void_p, ctypes.c_double, ctypes.c_int, OptionsP, ResultP))]
+
+COMPI_OK = 0
+COMPI_INVALID_ARGUMENT = 1
+COMPI_INTEGRAND_ERROR = 2
+COMPI_DOMAIN_ERROR = 3
+
+COMPI_TRAPEZOIDAL = 0
+COMPI_GAUSS_KRONROD = 1
+COMPI_TANH_SINH = 2
+COMPI_SINH_SINH = 3
+COMPI_EXP_SINH = 4
+
+def get_api():
+    get_pointer = ctypes.pythonapi.PyCapsule_GetPointer
+    get_pointer.restype = ctypes.c_void_p
+    get_pointer.argtypes = [ctypes.py_object, ctypes.c_char_p]
+    return ctypes.cast(get_pointer(compi._C_API, b"compi._C_API"), ctypes.POINTER(API)).contents
+
+def native_integrand(f):
+    '''
+    Wraps a Python function of x as a CompiIntegrand, ignoring the context
+    '''
+    def integrand(x, context, value):
+        result = complex(f(x))
+        value[0].real = result.real
+        value[0].imag = result.imag
+        return 0
+    return Integrand(integrand)
+
+class TestCAPI(unittest.TestCase):
+
+    def setUp(self):
+        self.api = get_api()
+        self.result = Result()
+
+    def assertResultAlmostEqual(self, expected, places=7):
+        self.assertAlmostEqual(expected.real, self.result.result.real, places=places)
+        self.assertAlmostEqual(expected.imag, self.result.result.imag, places=places)
+
+    def test_version(self):
+        self.assertGreaterEqual(self.api.version, 1)
+
+    def test_default_options(self):
+        for routine in (COMPI_GAUSS_KRONROD, COMPI_TANH_SINH, COMPI_SINH_SINH, COMPI_EXP_SINH):
+            with self.subTest(routine=routine):
+                options = Options(0, 0.0)
+                options.size = 0
+                self.assertEqual(COMPI_OK, self.api.default_options(routine, ctypes.byref(options)))
+                self.assertEqual(ctypes.sizeof(Options), options.size)
+                self.assertEqual(15, options.max_levels)
+                self.assertAlmostEqual(math.sqrt(2.0**-52), options.tolerance)
+                self.assertEqual(0.0, options.atol)
+
+        options = Options()
+        self.assertEqual(COMPI_OK, self.api.default_options(COMPI_TRAPEZOIDAL, ctypes.byref(options)))
+        self.assertEqual(12, options.max_levels)
+        self.assertEqual(2.0**-52, options.tolerance)
+
+        self.assertEqual(COMPI_INVALID_ARGUMENT, self.api.default_options(5, ctypes.byref(options)))
+
+    def test_trapezoidal_defaults_match_python_interface(self):
+        f = lambda x: math.exp(x)
+        self.assertEqual(COMPI_OK, self.api.trapezoidal(native_integrand(f), None, 0.0, 1.0, None, ctypes.byref(self.result)))
+        result, err = compi.trapezoidal(f, 0.0, 1.0)
+
+        self.assertEqual(result, complex(self.result.result.real, self.result.result.imag))
+        self.assertEqual(err, self.result.error)
+
+    def test_finite_routines(self):
+        f = native_integrand(lambda x: 3j*x*x)
+        # The default tolerance of trapezoidal, machine epsilon, is not reached for this integrand
+        trapezoidal_options = Options(15, 1e-8)
+        calls = {"trapezoidal": lambda: self.api.trapezoidal(f, None, 0.0, 1.0, ctypes.byref(trapezoidal_options), ctypes.byref(self.result)),
+                 "gauss_kronrod": lambda: self.api.gauss_kronrod(f, None, 0.0, 1.0, 31, None, ctypes.byref(self.result)),
+                 "tanh_sinh": lambda: self.api.tanh_sinh(f, None, 0.0, 1.0, None, ctypes.byref(self.result))}
+        for name, call in calls.items():
+            with self.subTest(routine=name):
+                self.assertEqual(COMPI_OK, call())
+                self.assertResultAlmostEqual(1j)
+                self.assertTrue(self.result.converged)
+
+    def test_matches_python_interface(self):
+        f = lambda x: math.exp(-x*x)
+        self.assertEqual(COMPI_OK, self.api.tanh_sinh(native_integrand(f), None, -1.0, 1.0, None, ctypes.byref(self.result)))
+        result, err, diagnostics = compi.tanh_sinh(f, -1.0, 1.0, full_output=True)
+
+        self.assertEqual(result, complex(self.result.result.real, self.result.result.imag))
+        self.assertEqual(err, self.result.error)
+        self.assertEqual(diagnostics["levels"], self.result.levels)
+
+    def test_infinite_routines(self):
+        gaussian = native_integrand(lambda x: math.exp(-x*x))
+        self.assertEqual(COMPI_OK, self.api.sinh_sinh(gaussian, None, None, ctypes.byref(self.result)))
+        self.assertResultAlmostEqual(math.sqrt(math.pi))
+
+        decaying = native_integrand(lambda x: math.exp(-abs(x)))
+        for direction in (1, -1):
+            self.assertEqual(COMPI_OK, self.api.exp_sinh(decaying, None, 0.0, direction, None, ctypes.byref(self.result)))
+            self.assertResultAlmostEqual(1.0)
+
+    def test_options_used(self):
+        f = lambda x: 1/(0.501 - x + 1e-3j)
+        options = Options(0, 1e-10)
+        self.assertEqual(COMPI_OK, self.api.gauss_kronrod(native_integrand(f), None, -1.0, 1.0, 15, ctypes.byref(options), ctypes.byref(self.result)))
+        result, err, diagnostics = compi.gauss_kronrod(f, -1.0, 1.0, max_levels=0, tolerance=1e-10, points=15, full_output=True)
+
+        self.assertEqual(result, complex(self.result.result.real, self.result.result.imag))
+        self.assertEqual(err, self.result.error)
+        self.assertEqual(diagnostics["converged"], bool(self.result.converged))
+        self.assertFalse(self.result.converged)
+
+    def test_atol_used(self):
+        f = lambda x: cmath.exp(-0.25*abs(x) + 1j*x)*abs(x - 0.3)**0.5
+        options = Options(15, 1e-15, 1e-3)
+        self.assertEqual(COMPI_OK, self.api.gauss_kronrod(native_integrand(f), None, -1.0, 1.0, 15, ctypes.byref(options), ctypes.byref(self.result)))
+        result, err, diagnostics = compi.gauss_kronrod(f, -1.0, 1.0, tolerance=1e-15, atol=1e-3, points=15, full_output=True)
+
+        self.assertEqual(result, complex(self.result.result.real, self.result.result.imag))
+        self.assertEqual(err, self.result.error)
+        self.assertEqual("absolute", diagnostics["criterion"])
+        self.assertTrue(self.result.converged)
+
+    def test_context_passed_to_integrand(self):
+        contexts = []
+        def integrand(x, context, value):
+            contexts.append(context)
+            value[0].real = 1.0
+            value[0].imag = 0.0
+            return 0
+
+        context = ctypes.c_double(2.0)
+        self.api.gauss_kronrod(Integrand(integrand), ctypes.addressof(context), 0.0, 1.0, 15, None, ctypes.byref(self.result))
+        self.assertTrue(contexts)
+        self.assertTrue(all(c == ctypes.addressof(context) for c in contexts))
+
+    def test_integrand_error_stops_integration(self):
+        evaluations = 0
+        def integrand(x, context, value):
+            nonlocal evaluations
+            evaluations += 1
+            return 1
+
+        status = self.api.tanh_sinh(Integrand(integrand), None, 0.0, 1.0, None, ctypes.byref(self.result))
+        self.assertEqual(COMPI_INTEGRAND_ERROR, status)
+        self.assertEqual(1, evaluations)
+        self.assertEqual(b"The integrand returned an error", self.api.status_message(status))
+
+    def test_invalid_arguments(self):
+        f = native_integrand(lambda x: 1.0)
+        self.assertEqual(COMPI_INVALID_ARGUMENT, self.api.gauss_kronrod(f, None, 0.0, 1.0, 17, None, ctypes.byref(self.result)))
+        self.assertEqual(COMPI_INVALID_ARGUMENT, self.api.exp_sinh(f, None, 0.0, 0, None, ctypes.byref(self.result)))
+        self.assertEqual(COMPI_INVALID_ARGUMENT, self.api.trapezoidal(f, None, 0.0, math.inf, None, ctypes.byref(self.result)))
+        self.assertEqual(COMPI_INVALID_ARGUMENT, self.api.tanh_sinh(f, None, 0.0, 1.0, None, None))
+        self.assertEqual(COMPI_INVALID_ARGUMENT, self.api.tanh_sinh(f, None, 0.0, 1.0, ctypes.byref(Options(15, -1.0)), ctypes.byref(self.result)))
+        self.assertEqual(COMPI_INVALID_ARGUMENT, self.api.tanh_sinh(f, None, 0.0, 1.0, ctypes.byref(Options(15, 1e-8, -1.0)), ctypes.byref(self.result)))
+        self.assertEqual(COMPI_INVALID_ARGUMENT, self.api.tanh_sinh(f, None, 0.0, 1.0, ctypes.byref(Options(15, 1e-8, math.nan)), ctypes.byref(self.result)))
+
+    def test_options_size_checked(self):
+        f = native_integrand(lambda x: 1.0)
+        # Every option of version 1 of the API, up to atol, must be given
+        for size in (0, Options.atol.offset, ctypes.sizeof(Options) + 8):
+            with self.subTest(size=size):
+                options = Options()
+                options.size = size
+                self.assertEqual(COMPI_INVALID_ARGUMENT, self.api.tanh_sinh(f, None, 0.0, 1.0, ctypes.byref(options), ctypes.byref(self.result)))
+
+    def test_domain_error(self):
+        f = native_integrand(lambda x: 1.0)
+        self.assertEqual(COMPI_DOMAIN_ERROR, self.api.sinh_sinh(f, None, None, ctypes.byref(self.result)))
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,137 @@
+import unittest
+import cmath,math
+
+import compi
+import compi_pool
+
+def lorentzian(x,x0=0.0):
+    return 1j/(1+(x-x0)**2)
+
+def decaying_exp(x):
+    return 1j*math.exp(-abs(x))
+
+def shifted_exp(x,shift):
+    return cmath.exp((-1+1j)*(x-shift))
+
+class TestIntegrationPoolError(Exception):
+    pass
+
+def raising_function(x):
+    raise TestIntegrationPoolError("Oh No!")
+
+class TestIntegrationPool(unittest.TestCase):
+
+    @classmethod
+    def setUpClass(cls):
+        cls.pool = compi_pool.IntegrationPool(lorentzian,processes=2)
+
+    @classmethod
+    def tearDownClass(cls):
+        cls.pool.close()
+
+    def test_map_matches_serial_results(self):
+        bounds = [(-1.0,1.0),(0.0,2.0),(-5.0,3.0),(1.0,10.0),(2.0,2.5)]
+        results = self.pool.map("gauss_kronrod",bounds)
+
+        self.assertEqual(len(bounds),len(results))
+        for b,(result,err) in zip(bounds,results):
+            expected,expected_err = compi.gauss_kronrod(lorentzian,*b)
+            self.assertAlmostEqual(expected,result,places=12)
+            self.assertIsInstance(err,float)
+
+    def test_map_passes_options(self):
+        results = self.pool.map("tanh_sinh",[(-1.0,1.0)],max_levels=0)
+        expected,_ = compi.tanh_sinh(lorentzian,-1.0,1.0,max_levels=0)
+        self.assertAlmostEqual(expected,results[0][0],places=12)
+
+    def test_map_reuses_pool_for_larger_batches(self):
+        for n in (1,3,20):
+            results = self.pool.map("trapezoidal",[(0.0,1.0)]*n)
+            self.assertEqual(n,len(results))
+
+    def test_map_empty_batch(self):
+        self.assertEqual([],self.pool.map("gauss_kronrod",[]))
+
+    def test_subdivide(self):
+        result,err = self.pool.subdivide("gauss_kronrod",-10.0,10.0,pieces=7)
+        self.assertAlmostEqual(2j*math.atan(10.0),result,places=12)
+        self.assertIsInstance(err,float)
+
+    def test_ValueError_for_wrong_number_of_bounds(self):
+        self.assertRaises(ValueError,self.pool.map,"gauss_kronrod",[(0.0,)])
+
+    def test_ValueError_for_unknown_method(self):
+        self.assertRaises(ValueError,self.pool.map,"simpson",[(0.0,1.0)])
+
+    def test_ValueError_for_subdividing_infinite_routine(self):
+        self.assertRaises(ValueError,self.pool.subdivide,"sinh_sinh",0.0,1.0)
+
+class TestIntegrationPoolArgs(unittest.TestCase):
+
+    def test_args_passed_to_integrand(self):
+        with compi_pool.IntegrationPool(shifted_exp,args=(1.0,),processes=2) as pool:
+            (result,_), = pool.map("exp_sinh",[(1.0,)])
+        self.assertAlmostEqual(0.5+0.5j,result,places=7)
+
+    def test_map_infinite_routines(self):
+        with compi_pool.IntegrationPool(decaying_exp,processes=2) as pool:
+            (result,_), = pool.map("sinh_sinh",[()])
+            self.assertAlmostEqual(2j,result,places=7)
+            (result,_), = pool.map("exp_sinh",[(0.0,)])
+            self.assertAlmostEqual(1j,result,places=7)
+
+    def test_kwargs_passed_to_integrand(self):
+        with compi_pool.IntegrationPool(lorentzian,kwargs={'x0':3.0},processes=1) as pool:
+            (result,_), = pool.map("gauss_kronrod",[(2.0,4.0)])
+        self.assertAlmostEqual(2j*math.atan(1.0),result,places=12)
+
+    def test_integrand_error_raised_in_parent(self):
+        with compi_pool.IntegrationPool(raising_function,processes=2) as pool:
+            self.assertRaises(TestIntegrationPoolError,pool.map,"gauss_kronrod",[(0.0,1.0)]*4)
+
+    def test_ValueError_for_uncallable_integrand(self):
+        self.assertRaises(ValueError,compi_pool.IntegrationPool,"Not a function")
+
+    def test_ValueError_after_close(self):
+        pool = compi_pool.IntegrationPool(lorentzian,processes=1)
+        pool.close()
+        self.assertRaises(ValueError,pool.map,"gauss_kronrod",[(0.0,1.0)])
+
+class TestThreadIntegrationPool(unittest.TestCase):
+
+    def test_map_matches_serial_results(self):
+        bounds = [(-1.0,1.0),(0.0,2.0),(-5.0,3.0),(1.0,10.0),(2.0,2.5)]
+        with compi_pool.ThreadIntegrationPool(lorentzian,threads=3) as pool:
+            results = pool.map("gauss_kronrod",bounds)
+
+        for b,(result,_) in zip(bounds,results):
+            expected,_ = compi.gauss_kronrod(lorentzian,*b)
+            self.assertAlmostEqual(expected,result,places=12)
+
+    def test_concurrent_shared_node_tables(self):
+        '''
+        Runs many routines using the shared node tables concurrently, with different max_levels
+        '''
+        with compi_pool.ThreadIntegrationPool(decaying_exp,threads=4) as pool:
+            for method,bounds in (("tanh_sinh",(-1.0,2.0)),("exp_sinh",(0.0,)),("sinh_sinh",())):
+                for max_levels in (4,7,10):
+                    expected,_ = getattr(compi,method)(decaying_exp,*bounds,max_levels=max_levels)
+                    for result,_ in pool.map(method,[bounds]*16,max_levels=max_levels):
+                        self.assertEqual(expected,result)
+
+    def test_subdivide_with_kwargs(self):
+        with compi_pool.ThreadIntegrationPool(lorentzian,kwargs={'x0':3.0},threads=2) as pool:
+            result,_ = pool.subdivide("tanh_sinh",2.0,4.0,pieces=4)
+        self.assertAlmostEqual(2j*math.atan(1.0),result,places=12)
+
+    def test_integrand_error_raised(self):
+        with compi_pool.ThreadIntegrationPool(raising_function,threads=2) as pool:
+            self.assertRaises(TestIntegrationPoolError,pool.map,"gauss_kronrod",[(0.0,1.0)]*4)
+
+    def test_ValueError_after_close(self):
+        pool = compi_pool.ThreadIntegrationPool(lorentzian,threads=1)
+        pool.close()
+        self.assertRaises(ValueError,pool.map,"gauss_kronrod",[(0.0,1.0)])
+
+if __name__ == '__main__':
+    unittest.main()
@@ -11,7 +11,7 @@ class TestExpSinh(known_interval_tests.TestSemiInfiniteIntegration):
     def test_full_output_contains_L1_norm_levels(self):
         _,_,diagnostics = self.routine_to_test(self.func,*self.default_range,full_output=True)
 
-        self.assertSetEqual({"L1 norm", "levels"}, set(diagnostics.keys()))
+        self.assertSetEqual({"L1 norm", "levels", "converged", "criterion"}, set(diagnostics.keys()))
         self.assertIsInstance(diagnostics["L1 norm"], float)
         self.assertIsInstance(diagnostics["levels"], int)
 
@@ -0,0 +1,87 @@
+import unittest
+import cmath,math
+
+import compi
+
+class TestExpressions(unittest.TestCase):
+    '''
+    Checks the parsing and evaluation of expression integrands, by integrating
+    constant expressions over an interval of length 1
+    '''
+
+    def evaluate(self,expression,parameters=None):
+        result,_ = compi.gauss_kronrod(expression,0.0,1.0,None,parameters,max_levels=0,points=15)
+        return result
+
+    def assertEvaluatesTo(self,expression,expected,parameters=None):
+        self.assertAlmostEqual(expected,self.evaluate(expression,parameters),places=12,msg=expression)
+
+    def test_literals(self):
+        self.assertEvaluatesTo("2",2)
+        self.assertEvaluatesTo("2.5",2.5)
+        self.assertEvaluatesTo(".5",0.5)
+        self.assertEvaluatesTo("1e-3",1e-3)
+        self.assertEvaluatesTo("2.5e2",250)
+        self.assertEvaluatesTo("3j",3j)
+        self.assertEvaluatesTo("1.5J",1.5j)
+
+    def test_operator_precedence(self):
+        self.assertEvaluatesTo("2+3*4",14)
+        self.assertEvaluatesTo("(2+3)*4",20)
+        self.assertEvaluatesTo("2-3-4",-5)
+        self.assertEvaluatesTo("24/4/3",2)
+        self.assertEvaluatesTo("-2**2",-4)
+        self.assertEvaluatesTo("2**-1",0.5)
+        self.assertEvaluatesTo("2**3**2",512)
+        self.assertEvaluatesTo("3*-2",-6)
+        self.assertEvaluatesTo("+-+2",-2)
+
+    def test_complex_arithmetic(self):
+        self.assertEvaluatesTo("(1+2j)*(3-1j)",(1+2j)*(3-1j))
+        self.assertEvaluatesTo("(1+2j)/(3-1j)",(1+2j)/(3-1j))
+        self.assertEvaluatesTo("(1+2j)**3",(1+2j)**3)
+        self.assertEvaluatesTo("(1+2j)**(0.5-1j)",(1+2j)**(0.5-1j))
+        self.assertEvaluatesTo("2**0.5",math.sqrt(2))
+
+    def test_constants(self):
+        self.assertEvaluatesTo("pi",math.pi)
+        self.assertEvaluatesTo("e",math.e)
+        self.assertEvaluatesTo("exp(1j*pi)",-1)
+
+    def test_functions(self):
+        z = 0.3+0.4j
+        for name in ("exp","log","sqrt","sin","cos","tan","sinh","cosh","tanh","asin","acos","atan","asinh","acosh","atanh"):
+            self.assertEvaluatesTo("{}(0.3+0.4j)".format(name),getattr(cmath,name)(z))
+        self.assertEvaluatesTo("abs(-3+4j)",5)
+        self.assertEvaluatesTo("conj(1+2j)",1-2j)
+        self.assertEvaluatesTo("real(1+2j)",1)
+        self.assertEvaluatesTo("imag(1+2j)",2)
+        self.assertEvaluatesTo("sqrt(-1)",1j)
+
+    def test_variable(self):
+        result,_ = compi.gauss_kronrod("x**2 - 2j*x",0.0,3.0)
+        self.assertAlmostEqual(9-9j,result,places=12)
+
+    def test_parameters(self):
+        self.assertEvaluatesTo("a*b + a",9j,{'a':3j,'b':2})
+        self.assertEvaluatesTo("omega_0**2",4,{'omega_0':2})
+
+    def test_same_expression_with_different_parameters(self):
+        for a in (1,2j,3.5):
+            self.assertEvaluatesTo("a",a,{'a':a})
+
+    def test_whitespace(self):
+        self.assertEvaluatesTo("  2 *\t( 3 + 1 )  ",8)
+
+    def test_ValueError_for_function_without_argument(self):
+        self.assertRaises(ValueError,self.evaluate,"exp")
+
+    def test_ValueError_for_non_numeric_parameter(self):
+        self.assertRaises(ValueError,self.evaluate,"a",{'a':"Not a number"})
+
+    def test_ValueError_for_trailing_input(self):
+        self.assertRaises(ValueError,self.evaluate,"2 3")
+        self.assertRaises(ValueError,self.evaluate,"2)")
+
+if __name__ == '__main__':
+    unittest.main()
@@ -33,7 +33,7 @@ class TestGaussKronrod(known_interval_tests.TestFiniteIntevalIntegration):
 
         _,_,diagnostics = self.routine_to_test(func,*self.default_range,full_output=True)
 
-        self.assertSetEqual({"L1 norm", "abscissa", "weights"}, set(diagnostics.keys()))
+        self.assertSetEqual({"L1 norm", "abscissa", "weights", "converged", "criterion"}, set(diagnostics.keys()))
         self.assertIsInstance(diagnostics["L1 norm"], float)
         self.assertIsInstance(diagnostics["abscissa"][0], float)
         self.assertIsInstance(diagnostics["weights"][0], float)
@@ -0,0 +1,115 @@
+import unittest
+import math
+
+import compi
+
+inf = math.inf
+
+class TestIntegrateWithGrad(unittest.TestCase):
+
+    def assertComplexAlmostEqual(self, expected, actual, places=9):
+        self.assertAlmostEqual(expected.real, actual.real, places=places)
+        self.assertAlmostEqual(expected.imag, actual.imag, places=places)
+
+    def finite_difference_gradient(self, f, a, b, kwargs, wrt, step=1e-5):
+        '''
+        Central differences of compi.tanh_sinh with respect to each parameter in wrt
+        '''
+        gradient = []
+        for name in wrt:
+            shifted = [dict(kwargs, **{name: kwargs[name] + sign*step}) for sign in (1,-1)]
+            upper, lower = (compi.tanh_sinh(f, a, b, None, kw, tolerance=1e-12)[0] for kw in shifted)
+            gradient.append((upper - lower)/(2*step))
+        return gradient
+
+    def test_gaussian_over_real_line(self):
+        result, gradient, err = compi.integrate_with_grad("exp(-a*x**2)", -inf, inf, {'a': 2.0})
+
+        self.assertComplexAlmostEqual(math.sqrt(math.pi/2), result, places=12)
+        self.assertEqual(1, len(gradient))
+        self.assertComplexAlmostEqual(-0.5*math.sqrt(math.pi)*2.0**-1.5, gradient[0], places=12)
+        self.assertIsInstance(err, float)
+
+    def test_complex_parameters_semi_infinite(self):
+        # The integral of exp(i*w*x - b*x) from 0 to infinity is 1/(b - i*w)
+        result, (d_w, d_b), _ = compi.integrate_with_grad("exp(1j*w*x - b*x)", 0.0, inf, {'w': 1.0, 'b': 2.0+0.5j})
+
+        expected = 1/(2.0+0.5j - 1j)
+        self.assertComplexAlmostEqual(expected, result)
+        self.assertComplexAlmostEqual(1j*expected**2, d_w)
+        self.assertComplexAlmostEqual(-expected**2, d_b)
+
+    def test_matches_finite_differences(self):
+        expressions = ("sin(c*x)*abs(a - x)**2",
+                       "exp(-a*x)*cos(c*x)/sqrt(1 + x)",
+                       "log(a + x**c)",
+                       "x**a*atan(c*x)",
+                       "real(exp(1j*c*x))*tanh(a*x)")
+        kwargs = {'a': 0.3, 'c': 1.7}
+        for f in expressions:
+            with self.subTest(expression=f):
+                result, gradient, _ = compi.integrate_with_grad(f, 0.0, 1.0, kwargs)
+
+                self.assertComplexAlmostEqual(compi.tanh_sinh(f, 0.0, 1.0, None, kwargs)[0], result)
+                for expected, actual in zip(self.finite_difference_gradient(f, 0.0, 1.0, kwargs, ('a','c')), gradient):
+                    self.assertComplexAlmostEqual(expected, actual, places=6)
+
+    def test_wrt_selects_and_orders_derivatives(self):
+        f = "a*x + b*x**2"
+        _, gradient, _ = compi.integrate_with_grad(f, 0.0, 1.0, {'a': 1.0, 'b': 1.0}, wrt=('b', 'a'))
+        self.assertComplexAlmostEqual(1/3, gradient[0])
+        self.assertComplexAlmostEqual(1/2, gradient[1])
+
+        _, gradient, _ = compi.integrate_with_grad(f, 0.0, 1.0, {'a': 1.0, 'b': 1.0}, wrt=['a'])
+        self.assertEqual(1, len(gradient))
+
+    def test_reversed_range_negated(self):
+        result, gradient, _ = compi.integrate_with_grad("a*x", 1.0, 0.0, {'a': 3.0})
+        self.assertComplexAlmostEqual(-1.5, result)
+        self.assertComplexAlmostEqual(-0.5, gradient[0])
+
+    def test_full_output(self):
+        _, _, _, diagnostics = compi.integrate_with_grad("exp(-a*x)", 0.0, inf, {'a': 1.0}, full_output=True)
+
+        self.assertSetEqual({"L1 norm", "levels", "method", "converged", "criterion"}, set(diagnostics.keys()))
+        self.assertEqual("exp_sinh", diagnostics["method"])
+        self.assertTrue(diagnostics["converged"])
+
+    def test_atol(self):
+        # The kink at 0.3 stops tanh-sinh reaching a relative tolerance of 1e-15
+        f = "exp(-x)*abs(x - a)**1.5"
+        _, _, _, diagnostics = compi.integrate_with_grad(f, 0.0, 1.0, {'a': 0.3}, tolerance=1e-15, full_output=True)
+        self.assertIsNone(diagnostics["criterion"])
+
+        _, _, err, diagnostics = compi.integrate_with_grad(f, 0.0, 1.0, {'a': 0.3}, tolerance=1e-15, atol=1e-3, full_output=True)
+        self.assertEqual("absolute", diagnostics["criterion"])
+        self.assertLessEqual(err, 1e-3)
+
+        self.assertRaises(ValueError, compi.integrate_with_grad, f, 0.0, 1.0, {'a': 0.3}, atol=-1.0)
+
+    def test_same_evaluations_as_single_integration(self):
+        # The value and derivatives share the refinement, so use as many levels as the value alone
+        _, _, _, diagnostics = compi.integrate_with_grad("exp(-a*x**2)", -1.0, 1.0, {'a': 1.0}, full_output=True)
+        _, _, value_diagnostics = compi.tanh_sinh("exp(-a*x**2)", -1.0, 1.0, None, {'a': 1.0}, full_output=True)
+        self.assertLessEqual(diagnostics["levels"], value_diagnostics["levels"] + 1)
+
+    def test_ValueError_for_callable(self):
+        self.assertRaises(ValueError, compi.integrate_with_grad, lambda x, a: a*x, 0.0, 1.0, {'a': 1.0})
+
+    def test_ValueError_for_unknown_wrt(self):
+        self.assertRaises(ValueError, compi.integrate_with_grad, "a*x", 0.0, 1.0, {'a': 1.0}, wrt=('b',))
+
+    def test_ValueError_for_missing_parameter(self):
+        self.assertRaises(ValueError, compi.integrate_with_grad, "a*b*x", 0.0, 1.0, {'a': 1.0})
+
+    def test_ValueError_for_number_of_parameters(self):
+        self.assertRaises(ValueError, compi.integrate_with_grad, "x", 0.0, 1.0, {})
+
+        names = ["p%d" % i for i in range(9)]
+        self.assertRaises(ValueError, compi.integrate_with_grad, "+".join(names) + "+x", 0.0, 1.0, dict.fromkeys(names, 1.0))
+
+    def test_ValueError_for_nan_limit(self):
+        self.assertRaises(ValueError, compi.integrate_with_grad, "a*x", math.nan, 1.0, {'a': 1.0})
+
+if __name__ == '__main__':
+    unittest.main()
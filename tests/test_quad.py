@@ -0,0 +1,151 @@
+import unittest
+import cmath
+import math
+
+import compi
+import known_interval_tests
+
+inf = math.inf
+
+class QuadFullOutputTests:
+    def test_full_output_contains_L1_norm_method_evaluations(self):
+        _,_,diagnostics = self.routine_to_test(self.func,*self.default_range,full_output=True)
+
+        self.assertSetEqual({"L1 norm", "method", "evaluations", "converged", "criterion"}, set(diagnostics.keys()))
+        self.assertIsInstance(diagnostics["L1 norm"], float)
+        self.assertIsInstance(diagnostics["method"], str)
+        self.assertIsInstance(diagnostics["evaluations"], int)
+
+    def test_evaluations_counts_calls_to_integrand(self):
+        evaluations = 0
+        def test_function(x):
+            nonlocal evaluations
+            evaluations += 1
+            return self.func(x)
+
+        _,_,diagnostics = self.routine_to_test(test_function,*self.default_range,full_output=True)
+        self.assertEqual(evaluations,diagnostics["evaluations"])
+
+    def test_evaluations_counts_calls_to_integrand_after_max_evaluations(self):
+        evaluations = 0
+        def difficult_function(x):
+            nonlocal evaluations
+            evaluations += 1
+            return cmath.exp(-0.25*abs(x)+ 1j*x)/(0.501-x)
+
+        _ = self.routine_to_test(difficult_function,*self.default_range)
+        max_evaluations = evaluations - 1
+
+        evaluations = 0
+        _,_,diagnostics = self.routine_to_test(difficult_function,*self.default_range,max_evaluations=max_evaluations,full_output=True)
+        self.assertEqual(evaluations,diagnostics["evaluations"])
+        self.assertIsNotNone(diagnostics["method"])
+
+class TestQuadFinite(QuadFullOutputTests,known_interval_tests.TestFiniteIntevalIntegration):
+    def routine_to_test(self,f,*args,**kwargs):
+        return compi.quad(f,*args,**kwargs)
+
+    def test_smooth_integrand_uses_gauss_kronrod(self):
+        result,_,diagnostics = self.routine_to_test(lambda x: 3j*x**2,0.0,1.0,full_output=True)
+
+        self.assertEqual("gauss_kronrod",diagnostics["method"])
+        self.assertAlmostEqual(1j,result,places=12)
+
+    def test_refinement_continues_from_probe(self):
+        '''
+        An integrand which is not smooth enough for the probe, but is not singular at an
+        endpoint, is refined with adaptive 15 point Gauss-Kronrod quadrature starting from the
+        probe, with one more level than max_levels, so only the 4 samples next to the endpoints
+        are added to its evaluations
+        '''
+        evaluations = 0
+        def kink(x):
+            nonlocal evaluations
+            evaluations += 1
+            return abs(x-0.3)
+
+        expected,expected_err = compi.gauss_kronrod(kink,0.0,1.0,points=15,max_levels=16)
+        gauss_kronrod_evaluations = evaluations
+        result,err,diagnostics = self.routine_to_test(kink,0.0,1.0,full_output=True)
+
+        self.assertEqual("gauss_kronrod",diagnostics["method"])
+        self.assertEqual(gauss_kronrod_evaluations+4,diagnostics["evaluations"])
+        self.assertAlmostEqual(expected,result,places=14)
+        self.assertAlmostEqual(0.29,result.real,places=self.tolerance)
+
+    def test_max_evaluations_during_refinement_returns_probe(self):
+        '''
+        If the evaluations run out while the probe is being refined, the probe is returned
+        with its error estimate
+        '''
+        kink = lambda x: abs(x-0.3)**0.5
+        probe,probe_err = compi.gauss_kronrod(kink,-1.0,1.0,points=15,max_levels=0)
+
+        for max_evaluations in (20,204,408):
+            result,err,diagnostics = self.routine_to_test(kink,-1.0,1.0,max_evaluations=max_evaluations,full_output=True)
+
+            self.assertEqual("gauss_kronrod",diagnostics["method"])
+            self.assertEqual(max_evaluations,diagnostics["evaluations"])
+            self.assertFalse(diagnostics["converged"])
+            self.assertTrue(cmath.isfinite(result))
+            self.assertTrue(math.isfinite(err))
+
+        result,err = self.routine_to_test(kink,-1.0,1.0,max_evaluations=19)
+        self.assertEqual(probe,result)
+        self.assertEqual(probe_err,err)
+
+        result,_ = self.routine_to_test(kink,1.0,-1.0,max_evaluations=19)
+        self.assertEqual(-probe,result)
+
+    def test_endpoint_singularity_uses_tanh_sinh(self):
+        for f,a,b,expected in ((lambda x: 1j/math.sqrt(x),0.0,1.0,2j),
+                               (lambda x: 1j/math.sqrt(1-x),0.0,1.0,2j),
+                               (lambda x: math.log(x),0.0,1.0,-1.0)):
+            result,_,diagnostics = self.routine_to_test(f,a,b,full_output=True)
+
+            self.assertEqual("tanh_sinh",diagnostics["method"])
+            self.assertAlmostEqual(expected,result,places=self.tolerance)
+
+    def test_reversed_bounds_negate_result(self):
+        forward,*_ = self.routine_to_test(lambda x: cmath.exp(1j*x),0.0,1.0)
+        backward,*_ = self.routine_to_test(lambda x: cmath.exp(1j*x),1.0,0.0)
+
+        self.assertEqual(forward,-backward)
+
+    def test_equal_bounds_give_zero(self):
+        def test_function(x):
+            raise AssertionError("Integrand should not be evaluated")
+
+        result,err = self.routine_to_test(test_function,1.0,1.0)
+        self.assertEqual(0,result)
+        self.assertEqual(0,err)
+
+    def test_ValueError_for_nan_bounds(self):
+        self.assertRaises(ValueError,self.routine_to_test,self.func,math.nan,1.0)
+        self.assertRaises(ValueError,self.routine_to_test,self.func,0.0,math.nan)
+
+class TestQuadSemiInfinite(QuadFullOutputTests,known_interval_tests.TestSemiInfiniteIntegration):
+    def routine_to_test(self,f,*args,**kwargs):
+        return compi.quad(f,*args[:1],inf,*args[1:],**kwargs)
+
+    def test_uses_exp_sinh(self):
+        _,_,diagnostics = self.routine_to_test(self.func,*self.default_range,full_output=True)
+        self.assertEqual("exp_sinh",diagnostics["method"])
+
+    def test_negative_axis(self):
+        result,*_ = compi.quad(lambda x: 1j*cmath.exp(x),-inf,0.0)
+        self.assertAlmostEqual(1j,result,places=self.tolerance)
+
+        result,*_ = compi.quad(lambda x: 1j*cmath.exp(x),0.0,-inf)
+        self.assertAlmostEqual(-1j,result,places=self.tolerance)
+
+class TestQuadInfinite(QuadFullOutputTests,known_interval_tests.TestInfiniteIntegration):
+    def routine_to_test(self,f,*args,**kwargs):
+        return compi.quad(f,-inf,inf,*args,**kwargs)
+
+    def test_uses_sinh_sinh(self):
+        _,_,diagnostics = self.routine_to_test(self.func,*self.default_range,full_output=True)
+        self.assertEqual("sinh_sinh",diagnostics["method"])
+
+if __name__ == '__main__':
+    unittest.main()
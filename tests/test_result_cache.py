@@ -0,0 +1,244 @@
+import unittest
+import math
+import os
+import subprocess
+import sys
+import tempfile
+
+import compi
+
+evaluations = 0
+
+def counted_gaussian(x):
+    global evaluations
+    evaluations += 1
+    return math.exp(-x*x)
+
+scale = 1.0
+
+def scaled_gaussian(x):
+    return scale*math.exp(-x*x)
+
+class CountedIntegrand:
+    '''
+    Callable object, which is not a Python function, so is only cached with a cache_key
+    '''
+    def __init__(self):
+        self.evaluations = 0
+
+    def __call__(self,x,a=1.0):
+        self.evaluations += 1
+        return math.exp(-a*x*x)
+
+class TestResultCache(unittest.TestCase):
+
+    def setUp(self):
+        self.evaluations = 0
+        compi.configure_cache(16)
+        compi.clear_cache()
+
+    def tearDown(self):
+        compi.clear_cache()
+        compi.configure_cache(0)
+
+    def counted_function(self,x,a=1.0):
+        self.evaluations += 1
+        return math.exp(-a*x*x)
+
+    def test_cache_disabled_by_default(self):
+        compi.configure_cache(0)
+        first = compi.tanh_sinh(self.counted_function,-1.0,1.0,cache_key="gaussian")
+        evaluations = self.evaluations
+        second = compi.tanh_sinh(self.counted_function,-1.0,1.0,cache_key="gaussian")
+
+        self.assertEqual(first,second)
+        self.assertEqual(2*evaluations,self.evaluations)
+
+    def test_repeated_call_not_integrated(self):
+        first = compi.tanh_sinh(counted_gaussian,-1.0,1.0,cache_key="gaussian")
+        first_evaluations = evaluations
+        second = compi.tanh_sinh(counted_gaussian,-1.0,1.0,cache_key="gaussian")
+
+        self.assertEqual(first,second)
+        self.assertEqual(first_evaluations,evaluations)
+        self.assertEqual(1,compi.cache_info()["hits"])
+
+    def test_cached_full_output(self):
+        def f(x):
+            return math.exp(-x*x)
+
+        first = compi.gauss_kronrod(f,-1.0,1.0,full_output=True,cache_key="gaussian")
+        second = compi.gauss_kronrod(f,-1.0,1.0,full_output=True,cache_key="gaussian")
+
+        self.assertEqual(first,second)
+        self.assertEqual(1,compi.cache_info()["hits"])
+
+    def test_changing_arguments_changes_key(self):
+        def f(x,a=1.0):
+            return math.exp(-a*x*x)
+
+        calls = [((-1.0,1.0),{}),
+                 ((-1.0,2.0),{}),
+                 ((-1.0,1.0,(2.0,)),{}),
+                 ((-1.0,1.0,None,{'a':3.0}),{}),
+                 ((-1.0,1.0),{'tolerance':1e-3}),
+                 ((-1.0,1.0),{'max_levels':3}),
+                 ((-1.0,1.0),{'full_output':True})]
+        for args,kwargs in calls:
+            compi.tanh_sinh(f,*args,cache_key="gaussian",**kwargs)
+        compi.gauss_kronrod(f,-1.0,1.0,cache_key="gaussian")
+
+        self.assertEqual(0,compi.cache_info()["hits"])
+        self.assertEqual(len(calls)+1,compi.cache_info()["misses"])
+
+    def test_key_independent_of_how_arguments_are_passed(self):
+        def f(x,a=1.0):
+            return math.exp(-a*x*x)
+
+        first = compi.tanh_sinh(f,-1.0,1.0,None,{'a':2.0},cache_key="gaussian")
+        calls = [((f,-1,1,(),{'a':2.0}),{}),
+                 ((f,),{'a':-1.0,'b':1.0,'kwargs':{'a':2.0}}),
+                 ((),{'f':f,'a':-1.0,'b':1.0,'kwargs':{'a':2.0},'max_levels':15,'full_output':False})]
+        for args,kwargs in calls:
+            self.assertEqual(first,compi.tanh_sinh(*args,cache_key="gaussian",**kwargs))
+
+        self.assertEqual(len(calls),compi.cache_info()["hits"])
+        self.assertEqual(1,compi.cache_info()["misses"])
+
+    def test_functions_need_cache_key(self):
+        # The result depends on the global scale, which could not be part of an automatic key
+        global scale
+        scale = 1.0
+        first = compi.tanh_sinh(scaled_gaussian,-1.0,1.0)
+        scale = 2.0
+        second = compi.tanh_sinh(scaled_gaussian,-1.0,1.0)
+        scale = 1.0
+
+        self.assertAlmostEqual(2*first[0],second[0])
+        self.assertEqual(0,compi.cache_info()["hits"]+compi.cache_info()["misses"])
+
+    def test_cache_key_identifies_function(self):
+        results = []
+        for a in (1.0,2.0):
+            def f(x):
+                return math.exp(-a*x*x)
+            results.append(compi.tanh_sinh(f,-1.0,1.0,cache_key=("gaussian",a)))
+
+        self.assertNotEqual(results[0],results[1])
+        self.assertEqual(0,compi.cache_info()["hits"])
+        self.assertEqual(2,compi.cache_info()["misses"])
+
+    def test_expressions_cached(self):
+        first = compi.tanh_sinh("exp(-a*x**2)",-1.0,1.0,None,{'a':2.0})
+        second = compi.tanh_sinh("exp(-a*x**2)",-1.0,1.0,None,{'a':2.0})
+
+        self.assertEqual(first,second)
+        self.assertEqual(1,compi.cache_info()["hits"])
+
+    def test_callable_objects_need_cache_key(self):
+        f = CountedIntegrand()
+        compi.tanh_sinh(f,-1.0,1.0)
+        compi.tanh_sinh(f,-1.0,1.0)
+        self.assertEqual(0,compi.cache_info()["hits"]+compi.cache_info()["misses"])
+
+        f.evaluations = 0
+        compi.tanh_sinh(f,-1.0,1.0,cache_key="gaussian")
+        first_evaluations = f.evaluations
+        compi.tanh_sinh(f,-1.0,1.0,cache_key="gaussian")
+        self.assertEqual(1,compi.cache_info()["hits"])
+        self.assertEqual(first_evaluations,f.evaluations)
+
+    def test_unmarshallable_args_not_cached(self):
+        def f(x,a):
+            return math.exp(-a.real*x*x)
+
+        class Parameter:
+            real = 1.0
+
+        compi.tanh_sinh(f,-1.0,1.0,(Parameter(),),cache_key="gaussian")
+        compi.tanh_sinh(f,-1.0,1.0,(Parameter(),),cache_key="gaussian")
+        self.assertEqual(0,compi.cache_info()["hits"]+compi.cache_info()["misses"])
+
+    def test_timeout_not_cached(self):
+        compi.tanh_sinh(counted_gaussian,-1.0,1.0,timeout=100.0,cache_key="gaussian")
+        compi.tanh_sinh(counted_gaussian,-1.0,1.0,timeout=100.0,cache_key="gaussian")
+        self.assertEqual(0,compi.cache_info()["hits"]+compi.cache_info()["misses"])
+
+    def test_errors_not_cached(self):
+        def f(x):
+            raise ValueError("Test error")
+
+        self.assertRaises(ValueError,compi.tanh_sinh,f,-1.0,1.0,cache_key="error")
+        self.assertRaises(ValueError,compi.tanh_sinh,f,-1.0,1.0,cache_key="error")
+        self.assertEqual(0,compi.cache_info()["size"])
+
+    def test_least_recently_used_evicted(self):
+        compi.configure_cache(2)
+        for a in (1.0,2.0,1.0,3.0):
+            compi.tanh_sinh("exp(-a*x**2)",-1.0,1.0,None,{'a':a})
+        self.assertEqual(2,compi.cache_info()["size"])
+
+        compi.tanh_sinh("exp(-a*x**2)",-1.0,1.0,None,{'a':1.0})
+        compi.tanh_sinh("exp(-a*x**2)",-1.0,1.0,None,{'a':2.0})
+        self.assertEqual(2,compi.cache_info()["hits"])
+
+    def test_ValueError_for_negative_maxsize(self):
+        self.assertRaises(ValueError,compi.configure_cache,-1)
+
+class TestDiskResultCache(unittest.TestCase):
+
+    def setUp(self):
+        self.directory = tempfile.TemporaryDirectory()
+        compi.configure_cache(0,self.directory.name)
+
+    def tearDown(self):
+        compi.clear_cache(disk=True)
+        compi.configure_cache(0)
+        self.directory.cleanup()
+
+    def test_results_read_from_disk(self):
+        first = compi.sinh_sinh("exp(-x**2)")
+        second = compi.sinh_sinh("exp(-x**2)")
+
+        self.assertEqual(first,second)
+        self.assertEqual(1,compi.cache_info()["hits"])
+        self.assertEqual(1,len(os.listdir(self.directory.name)))
+
+    def test_files_in_other_formats_ignored(self):
+        compi.sinh_sinh("exp(-x**2)")
+        compi.clear_cache()
+        # Rewrites the file without its format version, as written by earlier versions of compi
+        path = os.path.join(self.directory.name,os.listdir(self.directory.name)[0])
+        with open(path,"rb") as file:
+            contents = file.read()
+        with open(path,"wb") as file:
+            file.write(contents[:8] + contents[16:])
+
+        compi.sinh_sinh("exp(-x**2)")
+        self.assertEqual(0,compi.cache_info()["hits"])
+        self.assertEqual(1,compi.cache_info()["misses"])
+
+    def test_clear_cache_removes_files(self):
+        compi.sinh_sinh("exp(-x**2)")
+        compi.clear_cache()
+        self.assertEqual(1,len(os.listdir(self.directory.name)))
+        compi.clear_cache(disk=True)
+        self.assertEqual(0,len(os.listdir(self.directory.name)))
+
+    def test_results_shared_between_processes(self):
+        script = ("import compi, sys\n"
+                  "compi.configure_cache(0, sys.argv[1])\n"
+                  "print(compi.exp_sinh('exp(-x)', 0.0))\n"
+                  "print(compi.cache_info()['hits'])\n")
+        environment = dict(os.environ, PYTHONPATH=os.pathsep.join(sys.path))
+
+        outputs = [subprocess.run([sys.executable,"-c",script,self.directory.name],env=environment,
+                                  check=True,capture_output=True,text=True).stdout.split()
+                   for _ in range(2)]
+
+        self.assertEqual(outputs[0][:-1],outputs[1][:-1])
+        self.assertEqual("0",outputs[0][-1])
+        self.assertEqual("1",outputs[1][-1])
+
+if __name__ == '__main__':
+    unittest.main()
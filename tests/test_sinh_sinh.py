@@ -1,4 +1,5 @@
 import unittest
+import math,cmath
 
 import known_interval_tests
 import compi
@@ -12,10 +13,25 @@ class TestSinhSinh(known_interval_tests.TestInfiniteIntegration):
     def test_full_output_contains_L1_norm_levels(self):
         _,_,diagnostics = self.routine_to_test(self.func,*self.default_range,full_output=True)
 
-        self.assertSetEqual({"L1 norm", "levels"}, set(diagnostics.keys()))
+        self.assertSetEqual({"L1 norm", "levels", "converged", "criterion"}, set(diagnostics.keys()))
         self.assertIsInstance(diagnostics["L1 norm"], float)
         self.assertIsInstance(diagnostics["levels"], int)
 
+    def test_max_evaluations_below_minimum_levels(self):
+        '''
+        sinh_sinh always allows at least 7 levels. A budget which runs out before then still
+        gives the estimate from the last level which was finished
+        '''
+        def slowly_decaying_function(x):
+            return cmath.exp(1j*x)/(1+x*x)
+
+        result,err,diagnostics = self.routine_to_test(slowly_decaying_function,max_evaluations=200,full_output=True)
+
+        self.assertTrue(cmath.isfinite(result))
+        self.assertTrue(math.isfinite(err))
+        self.assertLess(diagnostics["levels"], 7)
+        self.assertFalse(diagnostics["converged"])
+
 
 if __name__ == '__main__':
     unittest.main()
\ No newline at end of file
@@ -0,0 +1,42 @@
+import unittest
+import sys
+
+try:
+    import _interpreters as interpreters
+except ImportError:
+    try:
+        import _xxsubinterpreters as interpreters
+    except ImportError:
+        interpreters = None
+
+@unittest.skipIf(interpreters is None, "subinterpreters are not available in this version of Python")
+class TestSubinterpreters(unittest.TestCase):
+    '''
+    compi declares that it can be loaded into subinterpreters with their own GIL, so checks
+    that it can be imported and used in one
+    '''
+    def run_in_subinterpreter(self,code):
+        interpreter = interpreters.create()
+        try:
+            # The subinterpreter starts with the default sys.path, so is given this one to find compi
+            error = interpreters.run_string(interpreter,"import sys\nsys.path[:] = {!r}\n".format(sys.path) + code)
+        finally:
+            interpreters.destroy(interpreter)
+        if error is not None:
+            self.fail(error.formatted)
+
+    def test_integrate_in_subinterpreter(self):
+        self.run_in_subinterpreter(
+'''
+import math
+import compi
+
+result,err = compi.quad(lambda x: 1j*x*x,0.0,1.0)
+assert abs(result - 1j/3) < 1e-12, result
+
+result,err = compi.tanh_sinh("1/(1+x**2)",-1.0,1.0)
+assert abs(result - math.pi/2) < 1e-12, result
+''')
+
+if __name__ == '__main__':
+    unittest.main()
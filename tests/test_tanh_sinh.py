@@ -1,4 +1,5 @@
 import unittest
+import math,cmath
 
 import compi
 import known_interval_tests
@@ -10,9 +11,55 @@ class TestTanhSinh(known_interval_tests.TestFiniteIntevalIntegration):
     def test_full_output_contains_L1_norm_levels(self):
         _,_,diagnostics = self.routine_to_test(self.func,*self.default_range,full_output=True)
 
-        self.assertSetEqual({"L1 norm", "levels"}, set(diagnostics.keys()))
+        self.assertSetEqual({"L1 norm", "levels", "converged", "criterion"}, set(diagnostics.keys()))
         self.assertIsInstance(diagnostics["L1 norm"], float)
         self.assertIsInstance(diagnostics["levels"], int)
 
+    def test_full_output_after_max_evaluations(self):
+        '''
+        Checks that the diagnostics returned once the evaluation budget runs out describe the
+        last level which was finished
+        '''
+        def difficult_function(x):
+            return 1/math.sqrt(0.501-x) if x < 0.5 else 1.0
+
+        result,_,diagnostics = self.routine_to_test(difficult_function,-1,1,max_evaluations=900,full_output=True)
+
+        self.assertFalse(diagnostics["converged"])
+        self.assertEqual(8, diagnostics["levels"])
+        self.assertTrue(math.isfinite(diagnostics["L1 norm"]))
+        self.assertAlmostEqual(abs(result), diagnostics["L1 norm"], places=12)
+
+    def test_max_evaluations_below_minimum_levels(self):
+        '''
+        tanh_sinh always refines at least 4 levels. A budget which runs out before then still
+        gives the estimate from the last level which was finished
+        '''
+        def difficult_function(x):
+            return 1/math.sqrt(0.501-x) if x < 0.5 else 1.0
+
+        result,err,diagnostics = self.routine_to_test(difficult_function,-1,1,max_evaluations=50,full_output=True)
+
+        self.assertTrue(cmath.isfinite(result))
+        self.assertTrue(math.isfinite(err))
+        self.assertLess(diagnostics["levels"], 4)
+        self.assertFalse(diagnostics["converged"])
+
+    def test_max_evaluations_partial_result_scaled_to_range(self):
+        '''
+        The levels are integrated over (-1,1), so a partial result over a wider range must be
+        scaled in the same way as a complete one
+        '''
+        def difficult_function(x):
+            return 1/math.sqrt(0.501-x) if x < 0.5 else 1.0
+
+        result,err = self.routine_to_test(difficult_function,-1,1,max_evaluations=300)
+        wide_result,wide_err = self.routine_to_test(lambda x: difficult_function(x/3),-3,3,max_evaluations=300)
+        reversed_result,_ = self.routine_to_test(lambda x: difficult_function(x/3),3,-3,max_evaluations=300)
+
+        self.assertAlmostEqual(3*result, wide_result, places=12)
+        self.assertAlmostEqual(3*err, wide_err, places=12)
+        self.assertAlmostEqual(-wide_result, reversed_result, places=12)
+
 if __name__ == '__main__':
     unittest.main()
\ No newline at end of file
@@ -1,4 +1,5 @@
 import unittest
+import cmath,math
 
 import compi
 import known_interval_tests
@@ -15,5 +16,63 @@ class TestTrapiziodal(known_interval_tests.TestFiniteIntevalIntegration):
     def test_full_output_contains_l1_norm(self):
         _,_,diagnostics = self.routine_to_test(self.func,*self.default_range,full_output=True)        
 
-        self.assertSetEqual({"L1 norm"}, set(diagnostics.keys()))
-        self.assertIsInstance(diagnostics["L1 norm"], float)
\ No newline at end of file
+        self.assertSetEqual({"L1 norm", "converged", "criterion"}, set(diagnostics.keys()))
+        self.assertIsInstance(diagnostics["L1 norm"], float)
+
+    def test_accept_periodic_keyword(self):
+        self._accept_ketword_test('periodic',True)
+
+    def test_accept_romberg_keyword(self):
+        self._accept_ketword_test('romberg',True)
+
+    def test_ValueError_if_periodic_and_romberg(self):
+        self.assertRaises(ValueError,self.routine_to_test,self.func,*self.default_range,periodic=True,romberg=True)
+
+    def test_periodic_integral(self):
+        '''
+        The integral of exp(cos(x) + ix) over a period is 2*pi*I_1(1), where I_1 is a modified Bessel function
+        '''
+        result,*_ = self.routine_to_test(lambda x: cmath.exp(cmath.cos(x)+1j*x),0.0,2*math.pi,periodic=True)
+        self.assertAlmostEqual(result.real, 2*math.pi*0.5651591039924851,places=12)
+        self.assertAlmostEqual(result.imag, 0.0,places=12)
+
+    def test_periodic_error_estimate_when_not_converged(self):
+        '''
+        The integral of 1/(1.01 - cos(x)) over a period is 2*pi/sqrt(1.01**2 - 1). The constant
+        makes the change between levels small relative to the L1 norm, while it is still large
+        compared with the error
+        '''
+        expected = 2000*math.pi + 2*math.pi/math.sqrt(1.01**2 - 1)
+        result,err,diagnostics = self.routine_to_test(lambda x: 1000 + 1/(1.01 - math.cos(x)),0.0,2*math.pi,
+                                                      periodic=True,max_levels=6,tolerance=1e-12,full_output=True)
+        self.assertFalse(diagnostics["converged"])
+        self.assertGreaterEqual(err,abs(result - expected))
+
+    def test_periodic_uses_fewer_evaluations(self):
+        evaluations = []
+        def periodic_function(x):
+            evaluations.append(x)
+            return cmath.exp(cmath.sin(x) + 2j*x)
+
+        default_result,*_ = self.routine_to_test(periodic_function,0.0,2*math.pi)
+        default_evaluations = len(evaluations)
+        evaluations.clear()
+        periodic_result,*_ = self.routine_to_test(periodic_function,0.0,2*math.pi,periodic=True)
+
+        self.assertLess(len(evaluations),default_evaluations)
+        self.assertAlmostEqual(default_result,periodic_result,places=12)
+
+    def test_romberg_uses_fewer_evaluations(self):
+        evaluations = []
+        def smooth_function(x):
+            evaluations.append(x)
+            return cmath.exp((1+1j)*x)
+
+        expected_result = (cmath.exp(1+1j) - 1)/(1+1j)
+        default_result,*_ = self.routine_to_test(smooth_function,0.0,1.0,tolerance=1e-10)
+        default_evaluations = len(evaluations)
+        evaluations.clear()
+        romberg_result,*_ = self.routine_to_test(smooth_function,0.0,1.0,tolerance=1e-10,romberg=True)
+
+        self.assertLess(len(evaluations),default_evaluations)
+        self.assertAlmostEqual(expected_result,romberg_result,places=12)
@@ -0,0 +1,20 @@
+// Writes the double exponential node tables of compi_node_tables.hpp to a file, which the
+// Python extension memory maps when it is imported. Run by setup.py and CMake at build time.
+//      generate_node_tables path [levels]
+#include <cstdio>
+#include <cstdlib>
+
+#include "compi_node_tables.hpp"
+
+int main(int argc, char** argv){
+    if(argc < 2){
+        std::fprintf(stderr,"usage: %s path [levels]\n",argv[0]);
+        return 2;
+    }
+    const unsigned levels = argc > 2 ? static_cast<unsigned>(std::atoi(argv[2])) : compi::default_node_table_levels;
+    if(!compi::write_node_tables(argv[1],levels)){
+        std::fprintf(stderr,"could not write the node tables to %s\n",argv[1]);
+        return 1;
+    }
+    return 0;
+}